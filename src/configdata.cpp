@@ -61,6 +61,11 @@ void ConfigData::saveData()
     s.setValue("contactUrlPath", s_data.contactUrlPath);
     s.setValue("contactUrlArg", s_data.contactUrlArg);
     s.setValue("disconnectChannel", s_data.disconnectChannel);
+    s.setValue("pollPlaybackStatus", s_data.pollPlaybackStatus);
+    s.setValue("pollInterval", s_data.pollInterval);
+    s.setValue("keepMplayerIdle", s_data.keepMplayerIdle);
+    s.setValue("prefetchNextTrack", s_data.prefetchNextTrack);
+    s.setValue("prefetchSize", s_data.prefetchSize);
 }
 
 void ConfigData::loadData()
@@ -89,5 +94,10 @@ void ConfigData::loadData()
     s_data.contactUrlPath = s.value("contactUrlPath", "").toString();
     s_data.contactUrlArg = s.value("contactUrlArg", CONTACTURL_ARG_DEFAULT).toString();
     s_data.disconnectChannel = s.value("disconnectChannel", false).toBool();
+    s_data.pollPlaybackStatus = s.value("pollPlaybackStatus", false).toBool();
+    s_data.pollInterval = s.value("pollInterval", 200).toInt();
+    s_data.keepMplayerIdle = s.value("keepMplayerIdle", false).toBool();
+    s_data.prefetchNextTrack = s.value("prefetchNextTrack", true).toBool();
+    s_data.prefetchSize = s.value("prefetchSize", 16).toInt();
 }
 
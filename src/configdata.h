@@ -50,6 +50,11 @@ public:
         QString contactUrlPath;
         QString contactUrlArg;
         bool    disconnectChannel;
+        bool    pollPlaybackStatus;
+        int     pollInterval;
+        bool    keepMplayerIdle;
+        bool    prefetchNextTrack;
+        int     prefetchSize;       // MB
     };
 
     static Data* data() { return &s_data; }
@@ -87,6 +87,12 @@ ConfigDialog::ConfigDialog(QWidget* parent) : QDialog(parent)
     _groupBoxLimitLogLine->setFocusPolicy(Qt::NoFocus);
     connect(_groupBoxLimitLogLine, SIGNAL(toggled(bool)),
             this,                  SLOT(groupBoxLimitLogLine_toggled(bool)));
+    _groupBoxPollStatus->setFocusPolicy(Qt::NoFocus);
+    connect(_groupBoxPollStatus, SIGNAL(toggled(bool)),
+            this,                SLOT(groupBoxPollStatus_toggled(bool)));
+    _groupBoxPrefetch->setFocusPolicy(Qt::NoFocus);
+    connect(_groupBoxPrefetch, SIGNAL(toggled(bool)),
+            this,              SLOT(groupBoxPrefetch_toggled(bool)));
     _groupBoxContactUrlPath->setFocusPolicy(Qt::NoFocus);
 
     QPalette palette = _groupBoxCacheSize->palette();
@@ -152,6 +158,11 @@ void ConfigDialog::setData(const ConfigData::Data& data)
     _groupBoxLimitLogLine->setChecked(data.limitLogLine);
     _spinBoxLimitLogLine->setValue(data.logLineMax);
     _checkBoxDisconnectChannel->setChecked(data.disconnectChannel);
+    _groupBoxPollStatus->setChecked(data.pollPlaybackStatus);
+    _spinBoxPollInterval->setValue(data.pollInterval);
+    _checkBoxKeepMplayerIdle->setChecked(data.keepMplayerIdle);
+    _groupBoxPrefetch->setChecked(data.prefetchNextTrack);
+    _spinBoxPrefetchSize->setValue(data.prefetchSize);
     _groupBoxContactUrlPath->setChecked(data.useContactUrlPath);
     _lineEditContactUrlPath->setText(data.contactUrlPath);
     _lineEditContactUrlArg->setText(data.contactUrlArg);
@@ -182,6 +193,11 @@ void ConfigDialog::getData(ConfigData::Data* data)
     data->limitLogLine = _groupBoxLimitLogLine->isChecked();
     data->logLineMax = _spinBoxLimitLogLine->value();
     data->disconnectChannel = _checkBoxDisconnectChannel->isChecked();
+    data->pollPlaybackStatus = _groupBoxPollStatus->isChecked();
+    data->pollInterval = _spinBoxPollInterval->value();
+    data->keepMplayerIdle = _checkBoxKeepMplayerIdle->isChecked();
+    data->prefetchNextTrack = _groupBoxPrefetch->isChecked();
+    data->prefetchSize = _spinBoxPrefetchSize->value();
     data->useContactUrlPath = _groupBoxContactUrlPath->isChecked();
     data->contactUrlPath = _lineEditContactUrlPath->text();
     data->contactUrlArg = _lineEditContactUrlArg->text();
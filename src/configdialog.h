@@ -47,6 +47,8 @@ private slots:
     void checkBoxSoftVideoEq_clicked(bool checked);
     void groupBoxCacheSize_toggled(bool) { _spinBoxCacheStream->deselect(); }
     void groupBoxLimitLogLine_toggled(bool) { _spinBoxLimitLogLine->deselect(); }
+    void groupBoxPollStatus_toggled(bool) { _spinBoxPollInterval->deselect(); }
+    void groupBoxPrefetch_toggled(bool) { _spinBoxPrefetchSize->deselect(); }
     void buttonContactUrlArg_clicked();
 };
 
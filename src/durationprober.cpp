@@ -0,0 +1,192 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QProcess>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QElapsedTimer>
+#include "durationprober.h"
+#include "configdata.h"
+#include "metrics.h"
+
+namespace {
+
+class ProbeJob : public QRunnable
+{
+public:
+    ProbeJob(DurationProber* prober, const QString& program, const QString& path,
+             QSharedPointer<QAtomicInt> canceled, int generation)
+        : _prober(prober), _program(program), _path(path), _canceled(canceled),
+          _generation(generation) {}
+
+    void run();
+
+private:
+    int probe();
+
+    DurationProber*            _prober;
+    QString                    _program;
+    QString                    _path;
+    QSharedPointer<QAtomicInt> _canceled;
+    int                        _generation;
+};
+
+void ProbeJob::run()
+{
+    int duration = probe();
+    if( *_canceled != 0 ) {
+        Metrics::count("prober.canceled");
+        return;
+    }
+
+    QMetaObject::invokeMethod(_prober, "jobFinished", Qt::QueuedConnection,
+                              Q_ARG(QString, _path), Q_ARG(int, duration), Q_ARG(int, _generation));
+}
+
+// 取得できなかった場合は-1を返す
+int ProbeJob::probe()
+{
+    if( *_canceled != 0 || !QFile::exists(_path) )
+        return -1;
+
+    qint64 startTime = Metrics::now();
+
+    QProcess p;
+    p.start(_program, QStringList()
+            << "-identify" << "-frames" << "0"
+            << "-vo" << "null" << "-ao" << "null" << "-nolirc"
+            << "-msglevel" << "all=-1:identify=4"
+            << _path);
+
+    if( !p.waitForStarted() )
+        return -1;
+
+    QElapsedTimer timer;
+    timer.start();
+    while( !p.waitForFinished(100) ) {
+        if( *_canceled != 0 || timer.elapsed() > DurationProber::PROBE_TIMEOUT ) {
+            p.kill();
+            p.waitForFinished(1000);
+            return -1;
+        }
+    }
+
+    Metrics::sample("prober.probe_ms", Metrics::elapsedMsec(startTime));
+
+    foreach(const QByteArray& line, p.readAllStandardOutput().split('\n')) {
+        if( line.startsWith("ID_LENGTH=") ) {
+            double length = line.mid(10).trimmed().toDouble();
+            return length > 0 ? (int)length : -1;
+        }
+    }
+
+    return -1;
+}
+
+}
+
+DurationProber::DurationProber(QObject* parent) : QObject(parent)
+{
+    _pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    _generation = 0;
+
+    _timerBatch.setSingleShot(true);
+    _timerBatch.setInterval(BATCH_INTERVAL);
+    connect(&_timerBatch, SIGNAL(timeout()), this, SLOT(timerBatch_timeout()));
+}
+
+DurationProber::~DurationProber()
+{
+    cancelAll();
+    _pool.waitForDone();
+}
+
+void DurationProber::probe(const QString& path)
+{
+    QHash<QString, Job>::iterator it = _pending.find(path);
+    if( it != _pending.end() ) {
+        ++it->refs;
+        return;
+    }
+
+    QString program;
+    if( ConfigData::data()->useMplayerPath )
+        program = ConfigData::data()->mplayerPath;
+    else
+        program = "mplayer";
+
+    Job job;
+    job.canceled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    job.refs = 1;
+    job.generation = ++_generation;
+    _pending.insert(path, job);
+    _pool.start(new ProbeJob(this, program, path, job.canceled, job.generation));
+}
+
+// 同じパスの行が残っている間は中止しない。実行中のmplayerは終了させる
+void DurationProber::cancel(const QString& path)
+{
+    QHash<QString, Job>::iterator it = _pending.find(path);
+    if( it == _pending.end() || --it->refs > 0 )
+        return;
+
+    it->canceled->fetchAndStoreOrdered(1);
+    _pending.erase(it);
+}
+
+void DurationProber::cancelAll()
+{
+    foreach(const Job& job, _pending)
+        job.canceled->fetchAndStoreOrdered(1);
+
+    _pending.clear();
+    _batchPaths.clear();
+    _batchDurations.clear();
+    _timerBatch.stop();
+}
+
+void DurationProber::jobFinished(const QString& path, int duration, int generation)
+{
+    // 中止後に届いた結果は捨てる。中止後に同じパスを取得し直している場合、
+    // 中止した方の結果で新しい取得を終わらせない様に、generationで照合する
+    QHash<QString, Job>::iterator it = _pending.find(path);
+    if( it == _pending.end() || it->generation != generation )
+        return;
+
+    _pending.erase(it);
+
+    if( duration < 0 ) {
+        Metrics::count("prober.failed");
+        return;
+    }
+
+    _batchPaths << path;
+    _batchDurations << duration;
+
+    if( !_timerBatch.isActive() )
+        _timerBatch.start();
+}
+
+void DurationProber::timerBatch_timeout()
+{
+    QStringList paths = _batchPaths;
+    QList<int> durations = _batchDurations;
+    _batchPaths.clear();
+    _batchDurations.clear();
+
+    if( !paths.isEmpty() )
+        emit probed(paths, durations);
+}
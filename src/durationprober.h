@@ -0,0 +1,70 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DURATIONPROBER_H
+#define DURATIONPROBER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QHash>
+#include <QTimer>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+// ローカルファイルの再生時間を、mplayer -identify -frames 0 でバックグラウンドで取得する。
+// CPUのコア数までのmplayerを同時に実行し、
+// 結果はBATCH_INTERVALの間まとめてからprobed()で通知する
+class DurationProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum {
+        BATCH_INTERVAL = 300,       // ms
+        PROBE_TIMEOUT  = 10000,     // ms
+    };
+
+    DurationProber(QObject* parent);
+    ~DurationProber();
+
+    void probe(const QString& path);    // 同じパスは1回だけ取得し、probe()した回数を数える
+    void cancel(const QString& path);   // probe()した回数分呼ばれたら中止する
+    void cancelAll();
+
+signals:
+    void probed(const QStringList& paths, const QList<int>& durations);
+
+private slots:
+    void jobFinished(const QString& path, int duration, int generation);
+    void timerBatch_timeout();
+
+private:
+    QThreadPool _pool;
+    struct Job {
+        QSharedPointer<QAtomicInt> canceled;
+        int                        refs;        // probe()された回数。cancel()で減らし、0で中止する
+        int                        generation;  // ProbeJob毎に異なる番号。結果の照合に使う
+    };
+
+    QHash<QString, Job> _pending;   // 取得中のパスをキーとする
+    int                 _generation;
+
+    QTimer      _timerBatch;
+    QStringList _batchPaths;
+    QList<int>  _batchDurations;
+};
+
+#endif // DURATIONPROBER_H
@@ -0,0 +1,212 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QCoreApplication>
+#include <QSettings>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStringList>
+#include <QCryptographicHash>
+#include "identifycache.h"
+#include "commonlib.h"
+#include "metrics.h"
+
+QHash<QString, IdentifyCache::Record> IdentifyCache::s_records;
+QSet<QString>                         IdentifyCache::s_dirty;
+QSet<QString>                         IdentifyCache::s_removed;
+bool                                  IdentifyCache::s_loaded = false;
+IdentifyCache*                        IdentifyCache::s_instance = NULL;
+
+bool IdentifyCache::Entry::operator==(const Entry& other) const
+{
+    return length == other.length
+        && seekable == other.seekable
+        && fileFormat == other.fileFormat
+        && videoSize == other.videoSize
+        && existVideo == other.existVideo
+        && existAudio == other.existAudio
+        && lengthOnly == other.lengthOnly;
+}
+
+IdentifyCache::IdentifyCache() : QObject(qApp)
+{
+    _timerFlush.setSingleShot(true);
+    _timerFlush.setInterval(FLUSH_DELAY);
+    connect(&_timerFlush, SIGNAL(timeout()), this, SLOT(timerFlush_timeout()));
+}
+
+bool IdentifyCache::find(const QString& path, Entry* entry)
+{
+    return find(path, QFileInfo(path), entry);
+}
+
+// infoはpathのもの。既にstat済みのQFileInfoを渡せば、改めてファイルを調べない
+bool IdentifyCache::find(const QString& path, const QFileInfo& info, Entry* entry)
+{
+    load();
+
+    QHash<QString, Record>::const_iterator it = s_records.constFind(key(path));
+    if( it == s_records.constEnd() ) {
+        Metrics::count("identify_cache.miss");
+        return false;
+    }
+
+    if( !info.exists() || info.size() != it->fileSize
+        || info.lastModified().toTime_t() != it->modified )
+    {
+        Metrics::count("identify_cache.stale");
+        return false;
+    }
+
+    *entry = it->entry;
+    Metrics::count("identify_cache.hit");
+    return true;
+}
+
+// 保存済みの内容と変わらない場合は何もしない。
+// 再生時間のみのエントリで、再生時に得た完全なエントリを上書きしない
+void IdentifyCache::store(const QString& path, const Entry& entry)
+{
+    QFileInfo info(path);
+    if( !info.exists() )
+        return;
+
+    load();
+
+    QString k = key(path);
+    qint64 fileSize = info.size();
+    uint modified = info.lastModified().toTime_t();
+
+    QHash<QString, Record>::const_iterator it = s_records.constFind(k);
+    if( it != s_records.constEnd() && it->fileSize == fileSize && it->modified == modified
+        && (it->entry == entry || (entry.lengthOnly && !it->entry.lengthOnly)) )
+    {
+        return;
+    }
+
+    Record record;
+    record.fileSize = fileSize;
+    record.modified = modified;
+    record.stored = QDateTime::currentDateTime().toTime_t();
+    record.path = path;
+    record.entry = entry;
+
+    s_records.insert(k, record);
+    s_dirty.insert(k);
+    s_removed.remove(k);
+
+    if( s_records.size() > ENTRIES_MAX ) {
+        QHash<QString, Record>::iterator oldest = s_records.begin();
+        for(QHash<QString, Record>::iterator it=s_records.begin(); it != s_records.end(); ++it) {
+            if( it->stored < oldest->stored )
+                oldest = it;
+        }
+
+        s_dirty.remove(oldest.key());
+        s_removed.insert(oldest.key());
+        s_records.erase(oldest);
+    }
+
+    scheduleFlush();
+}
+
+// 貯めた変更をファイルへ書き込む。終了時にも呼ぶ
+void IdentifyCache::flush()
+{
+    if( s_dirty.isEmpty() && s_removed.isEmpty() )
+        return;
+
+    qint64 startTime = Metrics::now();
+
+    QSettings s(QSettings::IniFormat, QSettings::UserScope, CommonLib::QSETTINGS_ORGNAME, "IdentifyCache");
+
+    foreach(const QString& k, s_removed)
+        s.remove(k);
+
+    foreach(const QString& k, s_dirty) {
+        const Record& record = s_records[k];
+
+        s.beginGroup(k);
+        s.setValue("path", record.path);
+        s.setValue("fileSize", record.fileSize);
+        s.setValue("modified", record.modified);
+        s.setValue("stored", record.stored);
+        s.setValue("length", record.entry.length);
+        s.setValue("seekable", record.entry.seekable);
+        s.setValue("fileFormat", record.entry.fileFormat);
+        s.setValue("videoSize", record.entry.videoSize);
+        s.setValue("existVideo", record.entry.existVideo);
+        s.setValue("existAudio", record.entry.existAudio);
+        s.setValue("lengthOnly", record.entry.lengthOnly);
+        s.endGroup();
+    }
+
+    s_removed.clear();
+    s_dirty.clear();
+
+    if( s_instance != NULL )
+        s_instance->_timerFlush.stop();
+
+    s.sync();
+    Metrics::sample("identify_cache.flush_ms", Metrics::elapsedMsec(startTime));
+}
+
+void IdentifyCache::scheduleFlush()
+{
+    if( s_instance == NULL )
+        s_instance = new IdentifyCache();
+
+    if( !s_instance->_timerFlush.isActive() )
+        s_instance->_timerFlush.start();
+}
+
+// 最初の呼び出し時にファイルから全て読み込む
+void IdentifyCache::load()
+{
+    if( s_loaded )
+        return;
+
+    s_loaded = true;
+
+    QSettings s(QSettings::IniFormat, QSettings::UserScope, CommonLib::QSETTINGS_ORGNAME, "IdentifyCache");
+
+    foreach(const QString& group, s.childGroups()) {
+        s.beginGroup(group);
+
+        Record record;
+        record.fileSize = s.value("fileSize", -1).toLongLong();
+        record.modified = s.value("modified", 0).toUInt();
+        record.stored = s.value("stored", 0).toUInt();
+        record.path = s.value("path").toString();
+        record.entry.length = s.value("length", 0).toDouble();
+        record.entry.seekable = s.value("seekable", false).toBool();
+        record.entry.fileFormat = s.value("fileFormat").toString();
+        record.entry.videoSize = s.value("videoSize").toSize();
+        record.entry.existVideo = s.value("existVideo", true).toBool();
+        record.entry.existAudio = s.value("existAudio", true).toBool();
+        record.entry.lengthOnly = s.value("lengthOnly", false).toBool();
+
+        s.endGroup();
+
+        if( record.fileSize >= 0 )
+            s_records.insert(group, record);
+    }
+}
+
+// iniのグループ名に使える様、パスのハッシュ値をキーにする
+QString IdentifyCache::key(const QString& path)
+{
+    return QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex();
+}
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef IDENTIFYCACHE_H
+#define IDENTIFYCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QSize>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+class QFileInfo;
+
+// ローカルファイルの-identifyの結果をファイルに保存し、次回の再生開始時に使う。
+// パス、ファイルサイズ、更新日時が一致する場合のみ有効とする。GUIスレッドから呼ぶ。
+// 変更はメモリ上に貯め、FLUSH_DELAY後、又はflush()でまとめてファイルへ書き込む
+class IdentifyCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum {
+        ENTRIES_MAX = 2000,
+        FLUSH_DELAY = 30000,    // ms
+    };
+
+    struct Entry {
+        double  length;
+        bool    seekable;
+        QString fileFormat;
+        QSize   videoSize;
+        bool    existVideo;
+        bool    existAudio;
+        bool    lengthOnly;     // DurationProberで再生時間のみ取得した場合
+
+        Entry() : length(0), seekable(false), existVideo(true), existAudio(true), lengthOnly(false) {}
+        bool operator==(const Entry& other) const;
+        bool operator!=(const Entry& other) const { return !(*this == other); }
+    };
+
+    static bool find(const QString& path, Entry* entry);
+    static bool find(const QString& path, const QFileInfo& info, Entry* entry);
+    static void store(const QString& path, const Entry& entry);
+    static void flush();
+
+private slots:
+    void timerFlush_timeout() { flush(); }
+
+private:
+    struct Record {
+        qint64 fileSize;
+        uint   modified;
+        uint   stored;      // 古いものから削除する
+        QString path;
+        Entry  entry;
+    };
+
+    IdentifyCache();
+
+    static void   load();
+    static void   scheduleFlush();
+    static QString key(const QString& path);
+
+    static QHash<QString, Record> s_records;   // key()をキーとする
+    static QSet<QString>          s_dirty;     // 未保存の変更があるkey()
+    static QSet<QString>          s_removed;   // 未保存の削除されたkey()
+    static bool                   s_loaded;
+    static IdentifyCache*         s_instance;  // 書き込みを遅らせるタイマーを持つ
+
+    QTimer _timerFlush;
+};
+
+#endif // IDENTIFYCACHE_H
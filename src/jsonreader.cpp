@@ -0,0 +1,326 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "jsonreader.h"
+#include "metrics.h"
+
+// 構文の検査は最初に一度だけ行う。以降の走査は検査済みを前提とする
+JsonReader::JsonReader(const QByteArray& data) : _data(data)
+{
+    qint64 startTime = Metrics::now();
+
+    _p = _data.constData();
+    _size = _data.size();
+
+    int i = skipValue(skipSpace(0), 0);
+    _valid = i != -1 && skipSpace(i) == _size;
+
+    Metrics::sample("json.parse_us", Metrics::now() - startTime);
+}
+
+QString JsonReader::toString(const QString& path) const
+{
+    int i = find(path);
+    if( i == -1 )
+        return QString();
+
+    if( _p[i] == '"' ) {
+        QString s;
+        decodeString(i, &s);
+        return s;
+    }
+
+    if( _p[i] == '{' || _p[i] == '[' || _p[i] == 'n' )
+        return QString();
+
+    return QString::fromLatin1(_p + i, skipValue(i, 0) - i);
+}
+
+int JsonReader::toInt(const QString& path) const
+{
+    return (int)toString(path).toDouble();
+}
+
+bool JsonReader::toBool(const QString& path) const
+{
+    int i = find(path);
+    if( i == -1 )
+        return false;
+
+    switch( _p[i] ) {
+    case 't': return true;
+    case 'f':
+    case 'n': return false;
+    case '"': return _p[i+1] != '"';
+    case '{':
+    case '[': return true;
+    default : return toString(path).toDouble() != 0;
+    }
+}
+
+int JsonReader::arraySize(const QString& path) const
+{
+    if( !_valid )
+        return -1;
+
+    int i = path.isEmpty() ? skipSpace(0) : find(path);
+    if( i == -1 || _p[i] != '[' )
+        return -1;
+
+    int count = 0;
+    i = skipSpace(i + 1);
+    while( _p[i] != ']' ) {
+        ++count;
+        i = skipSpace(skipValue(i, 0));
+        if( _p[i] == ',' )
+            i = skipSpace(i + 1);
+    }
+
+    return count;
+}
+
+// パスが指す値の先頭の位置を返す。見つからない場合は-1。
+// パスは分割せず、'.'で区切られた区間毎に辿る
+int JsonReader::find(const QString& path) const
+{
+    if( !_valid )
+        return -1;
+
+    int i = skipSpace(0);
+    const QChar* p   = path.constData();
+    const QChar* end = p + path.size();
+
+    while( p < end ) {
+        const QChar* keyEnd = p;
+        while( keyEnd < end && keyEnd->unicode() != '.' )
+            ++keyEnd;
+
+        if( keyEnd > p ) {
+            if( _p[i] == '{' )
+                i = findMember(i, p, keyEnd - p);
+            else
+            if( _p[i] == '[' ) {
+                int index = 0;
+                for(const QChar* c=p; c < keyEnd && i != -1; ++c) {
+                    if( c->unicode() < '0' || c->unicode() > '9' )
+                        i = -1;
+                    else
+                        index = index*10 + (c->unicode() - '0');
+                }
+
+                if( i != -1 )
+                    i = findElement(i, index);
+            }
+            else
+                return -1;
+
+            if( i == -1 )
+                return -1;
+        }
+
+        p = keyEnd + 1;
+    }
+
+    return i;
+}
+
+int JsonReader::findMember(int i, const QChar* key, int keySize) const
+{
+    i = skipSpace(i + 1);
+    while( _p[i] == '"' ) {
+        bool matched = equalsKey(i, key, keySize);
+
+        i = skipSpace(skipString(i));   // ':'
+        i = skipSpace(i + 1);
+        if( matched )
+            return i;
+
+        i = skipSpace(skipValue(i, 0));
+        if( _p[i] == ',' )
+            i = skipSpace(i + 1);
+    }
+
+    return -1;
+}
+
+// iは'"'の位置。メンバー名をデコードせずにkeyと比べる。
+// ASCII以外やエスケープを含む名前の場合のみデコードして比べる
+bool JsonReader::equalsKey(int i, const QChar* key, int keySize) const
+{
+    int n = 0;
+    for(int j=i+1; j < _size; ++j, ++n) {
+        uchar c = _p[j];
+        if( c == '"' )
+            return n == keySize;
+
+        if( c == '\\' || c >= 0x80 ) {
+            QString name;
+            decodeString(i, &name);
+            return name == QString::fromRawData(key, keySize);
+        }
+
+        if( n >= keySize || key[n].unicode() != c )
+            return false;
+    }
+
+    return false;
+}
+
+int JsonReader::findElement(int i, int index) const
+{
+    i = skipSpace(i + 1);
+    for(int n=0; _p[i] != ']'; ++n) {
+        if( n == index )
+            return i;
+
+        i = skipSpace(skipValue(i, 0));
+        if( _p[i] == ',' )
+            i = skipSpace(i + 1);
+    }
+
+    return -1;
+}
+
+// 値の直後の位置を返す。構文に誤りがある場合は-1
+int JsonReader::skipValue(int i, int depth) const
+{
+    if( i >= _size || depth > DEPTH_MAX )
+        return -1;
+
+    switch( _p[i] ) {
+    case '{':
+    case '[': {
+        char close = _p[i] == '{' ? '}' : ']';
+        i = skipSpace(i + 1);
+        if( i < _size && _p[i] == close )
+            return i + 1;
+
+        while( i < _size ) {
+            if( close == '}' ) {
+                if( _p[i] != '"' )
+                    return -1;
+
+                i = skipSpace(skipString(i));
+                if( i >= _size || _p[i] != ':' )
+                    return -1;
+
+                i = skipSpace(i + 1);
+            }
+
+            i = skipValue(i, depth + 1);
+            if( i == -1 )
+                return -1;
+
+            i = skipSpace(i);
+            if( i >= _size )
+                return -1;
+
+            if( _p[i] == close )
+                return i + 1;
+
+            if( _p[i] != ',' )
+                return -1;
+
+            i = skipSpace(i + 1);
+        }
+        return -1;
+    }
+
+    case '"':
+        return skipString(i);
+
+    case 't':
+        return qstrncmp(_p + i, "true", 4) == 0 ? i + 4 : -1;
+
+    case 'f':
+        return qstrncmp(_p + i, "false", 5) == 0 ? i + 5 : -1;
+
+    case 'n':
+        return qstrncmp(_p + i, "null", 4) == 0 ? i + 4 : -1;
+
+    default: {
+        int start = i;
+        while( i < _size && (('0' <= _p[i] && _p[i] <= '9') || _p[i] == '-' || _p[i] == '+'
+                             || _p[i] == '.' || _p[i] == 'e' || _p[i] == 'E') )
+        {
+            ++i;
+        }
+        return i > start ? i : -1;
+    }
+    }
+}
+
+// iは'"'の位置。閉じる'"'の直後の位置を返す
+int JsonReader::skipString(int i) const
+{
+    if( i == -1 )
+        return -1;
+
+    for(++i; i < _size; ++i) {
+        if( _p[i] == '\\' )
+            ++i;
+        else
+        if( _p[i] == '"' )
+            return i + 1;
+    }
+
+    return -1;
+}
+
+int JsonReader::skipSpace(int i) const
+{
+    if( i == -1 )
+        return -1;
+
+    while( i < _size && (_p[i] == ' ' || _p[i] == '\t' || _p[i] == '\n' || _p[i] == '\r') )
+        ++i;
+
+    return i;
+}
+
+// エスケープの無い区間はまとめてUTF-8から変換する
+bool JsonReader::decodeString(int i, QString* out) const
+{
+    out->clear();
+
+    int start = ++i;
+    for(; i < _size && _p[i] != '"'; ++i) {
+        if( _p[i] != '\\' )
+            continue;
+
+        out->append(QString::fromUtf8(_p + start, i - start));
+        ++i;
+
+        switch( _p[i] ) {
+        case 'b': out->append('\b'); break;
+        case 'f': out->append('\f'); break;
+        case 'n': out->append('\n'); break;
+        case 'r': out->append('\r'); break;
+        case 't': out->append('\t'); break;
+        case 'u':
+            if( i + 4 < _size ) {
+                out->append(QChar(QByteArray(_p + i + 1, 4).toUShort(0, 16)));
+                i += 4;
+            }
+            break;
+        default : out->append(QLatin1Char(_p[i])); break; // '"' '\\' '/'
+        }
+
+        start = i + 1;
+    }
+
+    out->append(QString::fromUtf8(_p + start, i - start));
+    return i < _size;
+}
@@ -0,0 +1,54 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QByteArray>
+#include <QString>
+
+// JSON文書から値を読み出す。木は作らず、値の取得の度に元のバイト列を走査する。
+// パスは"result.info.name"の様に'.'で区切り、配列の要素は"0.result"の様に添字で指定する
+class JsonReader
+{
+public:
+    enum { DEPTH_MAX = 64 };
+
+    explicit JsonReader(const QByteArray& data);
+
+    bool    isValid() const { return _valid; }
+    bool    contains(const QString& path) const { return find(path) != -1; }
+    QString toString(const QString& path) const;   // 数値、真偽値は表記のまま返す
+    int     toInt(const QString& path) const;      // 数値の文字列も変換する
+    bool    toBool(const QString& path) const;
+    int     arraySize(const QString& path) const;  // 配列で無い場合は-1
+
+private:
+    int  find(const QString& path) const;
+    int  skipValue(int i, int depth) const;
+    int  skipString(int i) const;
+    int  skipSpace(int i) const;
+    int  findMember(int i, const QChar* key, int keySize) const;
+    bool equalsKey(int i, const QChar* key, int keySize) const;
+    int  findElement(int i, int index) const;
+    bool decodeString(int i, QString* out) const;
+
+    QByteArray  _data;
+    const char* _p;
+    int         _size;
+    bool        _valid;
+};
+
+#endif // JSONREADER_H
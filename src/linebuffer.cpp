@@ -0,0 +1,127 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string.h>
+#include <QIODevice>
+#include "linebuffer.h"
+
+LineBuffer::LineBuffer(int capacity)
+{
+    if( capacity <= 0 )
+        capacity = DEFAULT_CAPACITY;
+
+    _capacity = capacity;
+    _buff     = new char[_capacity];
+    _linear   = new char[_capacity];
+
+    clear();
+}
+
+LineBuffer::~LineBuffer()
+{
+    delete[] _buff;
+    delete[] _linear;
+}
+
+// deviceから読み込める分だけバッファの空き領域へ直接読み込む。
+// 読み込んだバイト数を返す。
+int LineBuffer::readFrom(QIODevice* device)
+{
+    int total = 0;
+
+    while( _size < _capacity ) {
+        int tail = (_head + _size) % _capacity;
+        int free = _capacity - _size;
+        int contiguous = qMin(free, _capacity - tail);
+
+        qint64 n = device->read(_buff + tail, contiguous);
+        if( n <= 0 )
+            break;
+
+        _size += n;
+        total += n;
+
+        if( n < contiguous )
+            break;
+    }
+
+    return total;
+}
+
+// 完成している行を1行取り出す。行が無い場合はfalseを返す。
+// 返すポインタは次にreadFrom()、takeLine()、clear()を呼ぶまで有効。
+// バッファが一杯で改行文字が無い場合は、バッファ全体を1行として返す。
+bool LineBuffer::takeLine(const char** line, int* size)
+{
+    if( _skipLf && _size > 0 ) {
+        if( _buff[_head] == '\n' )
+            consume(1);
+
+        _skipLf = false;
+    }
+
+    int length = -1;
+    bool terminated = false;
+    for(int i=_scanned; i < _size; ++i) {
+        char c = _buff[(_head + i) % _capacity];
+        if( c == '\n' || c == '\r' ) {
+            length = i;
+            terminated = true;
+            _skipLf = (c == '\r');
+            break;
+        }
+    }
+
+    if( !terminated ) {
+        if( _size < _capacity ) {
+            _scanned = _size;
+            return false;
+        }
+
+        length = _size;
+    }
+
+    if( _head + length <= _capacity )
+        *line = _buff + _head;
+    else {
+        int first = _capacity - _head;
+        memcpy(_linear, _buff + _head, first);
+        memcpy(_linear + first, _buff, length - first);
+        *line = _linear;
+    }
+
+    *size = length;
+    consume(terminated ? length + 1 : length);
+
+    return true;
+}
+
+void LineBuffer::clear()
+{
+    _head = 0;
+    _size = 0;
+    _scanned = 0;
+    _skipLf = false;
+}
+
+void LineBuffer::consume(int size)
+{
+    _head = (_head + size) % _capacity;
+    _size -= size;
+    _scanned = 0;
+
+    if( _size == 0 )
+        _head = 0;
+}
@@ -0,0 +1,55 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LINEBUFFER_H
+#define LINEBUFFER_H
+
+class QIODevice;
+
+// 固定サイズのリングバッファ。
+// 読み込んだバイト列から'\r'または'\n'で終わる行を切り出す。
+// 未完成の行はバッファ内にそのまま残し、再確保は行わない。
+class LineBuffer
+{
+public:
+    enum { DEFAULT_CAPACITY = 16384 };
+
+    LineBuffer(int capacity=DEFAULT_CAPACITY);
+    ~LineBuffer();
+
+    int  readFrom(QIODevice* device);
+    bool takeLine(const char** line, int* size);
+    void clear();
+
+    int  size() const     { return _size; }
+    int  capacity() const { return _capacity; }
+    bool isFull() const   { return _size == _capacity; }
+
+private:
+    LineBuffer(const LineBuffer&);
+    LineBuffer& operator=(const LineBuffer&);
+
+    void consume(int size);
+
+    char* _buff;
+    char* _linear;      // バッファ終端で折り返した行の連結用
+    int   _capacity;
+    int   _head;        // 未処理データの先頭位置
+    int   _size;        // 未処理データのサイズ
+    int   _scanned;     // _headから改行文字を探索済みのサイズ
+    bool  _skipLf;      // "\r\n"の'\n'を読み飛ばす
+};
+
+#endif // LINEBUFFER_H
@@ -14,8 +14,10 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <QKeyEvent>
+#include <QThread>
 #include "logdialog.h"
 #include "windowcontroller.h"
+#include "metrics.h"
 
 LogDialog* LogDialog::s_logDialog;
 QWidget*   LogDialog::s_parent;
@@ -26,6 +28,7 @@ LogDialog::LogDialog(QWidget* parent) : QDialog(parent)
     setupUi(this);
 //  setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint);
     connect(_buttonClear, SIGNAL(clicked()), this, SLOT(clear()));
+    connect(_buttonMetrics, SIGNAL(clicked()), this, SLOT(printMetrics()));
     connect(_checkBoxStatusLine, SIGNAL(clicked(bool)), this, SIGNAL(requestOutputStatusLine(bool)));
 
     _textEdit->setTextColor(QColor(212,210,207));
@@ -50,6 +53,57 @@ void LogDialog::initDialog(QWidget* parent)
     s_parent = parent;
 }
 
+// print()、debug()はGUIスレッド以外からも呼べる。
+// その場合はGUIスレッドのイベントループで出力する。
+void LogDialog::print(const QString& text)
+{
+    if( QThread::currentThread() == s_logDialog->thread() )
+        s_logDialog->printOut(text);
+    else {
+        QMetaObject::invokeMethod(s_logDialog, "printOut", Qt::QueuedConnection,
+                                  Q_ARG(QString, text));
+    }
+}
+
+void LogDialog::print(const QString& text, const QColor& color)
+{
+    if( QThread::currentThread() == s_logDialog->thread() )
+        s_logDialog->printOut(text, color);
+    else {
+        QMetaObject::invokeMethod(s_logDialog, "printOut", Qt::QueuedConnection,
+                                  Q_ARG(QString, text), Q_ARG(QColor, color));
+    }
+}
+
+void LogDialog::debug(const QString& text)
+{
+#ifdef QT_NO_DEBUG_OUTPUT
+    Q_UNUSED(text);
+#else
+    if( QThread::currentThread() == s_logDialog->thread() )
+        s_logDialog->debugOut(text);
+    else {
+        QMetaObject::invokeMethod(s_logDialog, "debugOut", Qt::QueuedConnection,
+                                  Q_ARG(QString, text));
+    }
+#endif
+}
+
+void LogDialog::debug(const QString& text, const QColor& color)
+{
+#ifdef QT_NO_DEBUG_OUTPUT
+    Q_UNUSED(text);
+    Q_UNUSED(color);
+#else
+    if( QThread::currentThread() == s_logDialog->thread() )
+        s_logDialog->debugOut(text, color);
+    else {
+        QMetaObject::invokeMethod(s_logDialog, "debugOut", Qt::QueuedConnection,
+                                  Q_ARG(QString, text), Q_ARG(QColor, color));
+    }
+#endif
+}
+
 void LogDialog::printOut(const QString& text, const QColor& color)
 {
     QColor old = _textEdit->textColor();
@@ -62,6 +116,15 @@ void LogDialog::printOut(const QString& text, const QColor& color)
         qDebug(text.toAscii().constData());
 }
 
+void LogDialog::printMetrics()
+{
+    QString report = Metrics::report();
+    if( report.isEmpty() )
+        report = tr("計測値はありません");
+
+    printOut("[metrics]\n" + report, QColor(106,129,198));
+}
+
 void LogDialog::showDialog()
 {
     if( s_logDialog != NULL ) {
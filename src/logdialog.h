@@ -45,15 +45,15 @@ public slots:
     void debugOut(const QString& text);
     void debugOut(const QString& text, const QColor& color);
     void clear() { _textEdit->clear(); }
+    void printMetrics();
 
     static void moveDialog(int x, int y);
     static void showDialog();
     static void closeDialog();
     static void debug(const QString& text);
     static void debug(const QString& text, const QColor& color);
-    static void print(const QString& text) { s_logDialog->printOut(text); }
-    static void print(const QString& text, const QColor& color)
-                                           { s_logDialog->printOut(text, color); }
+    static void print(const QString& text);
+    static void print(const QString& text, const QColor& color);
 
 signals:
     void windowActivate();
@@ -141,24 +141,5 @@ inline void LogDialog::closeDialog()
         s_logDialog->close();
 }
 
-inline void LogDialog::debug(const QString& text)
-{
-#ifdef QT_NO_DEBUG_OUTPUT
-    Q_UNUSED(text);
-#else
-    s_logDialog->debugOut(text);
-#endif
-}
-
-inline void LogDialog::debug(const QString& text, const QColor& color)
-{
-#ifdef QT_NO_DEBUG_OUTPUT
-    Q_UNUSED(text);
-    Q_UNUSED(color);
-#else
-    s_logDialog->debugOut(text, color);
-#endif
-}
-
 #endif // define LOGDIALOG_H
 
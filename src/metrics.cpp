@@ -0,0 +1,176 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QMap>
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QtAlgorithms>
+#include "metrics.h"
+
+namespace {
+
+struct Distribution
+{
+    Distribution() : count(0), next(0) {}
+
+    qint64          count;
+    int             next;       // 次に上書きするvaluesの位置
+    QVector<double> values;
+};
+
+QMutex                      s_mutex;
+QMap<QString, qint64>       s_counters;
+QMap<QString, Distribution> s_distributions;
+
+QElapsedTimer startedTimer()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+}
+
+const QElapsedTimer s_timer = startedTimer();
+
+double percentile(const QVector<double>& sorted, double p)
+{
+    int i = (int)(p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+}
+
+qint64 Metrics::now()
+{
+    return s_timer.nsecsElapsed() / 1000;
+}
+
+void Metrics::count(const QString& name, qint64 value)
+{
+    QMutexLocker locker(&s_mutex);
+    s_counters[name] += value;
+}
+
+void Metrics::sample(const QString& name, double value)
+{
+    QMutexLocker locker(&s_mutex);
+
+    Distribution& d = s_distributions[name];
+    if( d.values.size() < SAMPLES_MAX )
+        d.values.append(value);
+    else {
+        d.values[d.next] = value;
+        d.next = (d.next + 1) % SAMPLES_MAX;
+    }
+
+    ++d.count;
+}
+
+// 複数の値を1回のロックで追加する
+void Metrics::sample(const QString& name, const double* values, int size)
+{
+    QMutexLocker locker(&s_mutex);
+
+    Distribution& d = s_distributions[name];
+    for(int i=0; i < size; ++i) {
+        if( d.values.size() < SAMPLES_MAX )
+            d.values.append(values[i]);
+        else {
+            d.values[d.next] = values[i];
+            d.next = (d.next + 1) % SAMPLES_MAX;
+        }
+    }
+
+    d.count += size;
+}
+
+qint64 Metrics::counter(const QString& name)
+{
+    QMutexLocker locker(&s_mutex);
+    return s_counters.value(name, 0);
+}
+
+bool Metrics::summary(const QString& name, Summary* summary)
+{
+    QMutexLocker locker(&s_mutex);
+
+    QMap<QString, Distribution>::const_iterator it = s_distributions.constFind(name);
+    if( it == s_distributions.constEnd() || it->values.isEmpty() )
+        return false;
+
+    QVector<double> sorted = it->values;
+    qint64 count = it->count;
+    locker.unlock();
+
+    qSort(sorted);
+
+    double total = 0;
+    for(int i=0; i < sorted.size(); ++i)
+        total += sorted[i];
+
+    summary->count = count;
+    summary->mean  = total / sorted.size();
+    summary->p50   = percentile(sorted, 0.50);
+    summary->p90   = percentile(sorted, 0.90);
+    summary->p99   = percentile(sorted, 0.99);
+    summary->max   = sorted.last();
+    return true;
+}
+
+QString Metrics::report()
+{
+    QMutexLocker locker(&s_mutex);
+    QMap<QString, qint64> counters = s_counters;
+    QStringList names = s_distributions.keys();
+    locker.unlock();
+
+    QStringList lines;
+
+    QMap<QString, qint64>::const_iterator it;
+    for(it=counters.constBegin(); it != counters.constEnd(); ++it)
+        lines << QString("%1: %2").arg(it.key()).arg(it.value());
+
+    foreach(const QString& name, names) {
+        Summary s;
+        if( !summary(name, &s) )
+            continue;
+
+        lines << QString("%1: n=%2 mean=%3 p50=%4 p90=%5 p99=%6 max=%7")
+                    .arg(name).arg(s.count)
+                    .arg(s.mean, 0, 'f', 2).arg(s.p50, 0, 'f', 2).arg(s.p90, 0, 'f', 2)
+                    .arg(s.p99, 0, 'f', 2).arg(s.max, 0, 'f', 2);
+    }
+
+    return lines.join("\n");
+}
+
+void Metrics::clear()
+{
+    QMutexLocker locker(&s_mutex);
+    s_counters.clear();
+    s_distributions.clear();
+}
+
+// ---------------------------------------------------------------------------------------
+void MetricsSampler::flush()
+{
+    if( _size == 0 )
+        return;
+
+    Metrics::sample(_name, _values, _size);
+    _size = 0;
+}
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QString>
+
+// 性能計測用のカウンタと分布の集計。どのスレッドからも呼べる
+class Metrics
+{
+public:
+    enum { SAMPLES_MAX = 1024 };   // 分布毎に保持する最新の値の数
+
+    struct Summary {
+        qint64 count;       // これまでに追加された値の数
+        double mean;        // 以下は保持している値から求める
+        double p50;
+        double p90;
+        double p99;
+        double max;
+    };
+
+    static qint64  now();                                       // 単調増加する時刻(マイクロ秒)
+    static double  elapsedMsec(qint64 since) { return (now() - since) / 1000.0; }
+
+    static void    count(const QString& name, qint64 value=1);  // カウンタへ加算
+    static void    sample(const QString& name, double value);   // 分布へ値を追加
+    static void    sample(const QString& name, const double* values, int size);
+    static qint64  counter(const QString& name);
+    static bool    summary(const QString& name, Summary* summary);
+    static QString report();
+    static void    clear();
+};
+
+// 頻繁に記録する分布の値を手元に貯め、BATCH_MAX個毎又はFLUSH_INTERVAL毎に
+// まとめてMetricsへ追加する。名前の文字列の生成とロックを値毎に行わずに済む。
+// 1つのスレッドから使う
+class MetricsSampler
+{
+public:
+    enum {
+        BATCH_MAX      = 64,
+        FLUSH_INTERVAL = 1000000,   // マイクロ秒
+    };
+
+    explicit MetricsSampler(const QString& name=QString()) : _name(name), _size(0), _firstTime(0) {}
+    ~MetricsSampler() { flush(); }
+
+    void setName(const QString& name) { flush(); _name = name; }
+    void add(double value, qint64 now);     // nowはMetrics::now()
+    void flush();
+
+private:
+    QString _name;
+    double  _values[BATCH_MAX];
+    int     _size;
+    qint64  _firstTime;         // 貯めている最初の値の時刻
+};
+
+inline void MetricsSampler::add(double value, qint64 now)
+{
+    if( _name.isEmpty() )
+        return;
+
+    if( _size == 0 )
+        _firstTime = now;
+
+    _values[_size++] = value;
+
+    if( _size == BATCH_MAX || now - _firstTime >= FLUSH_INTERVAL )
+        flush();
+}
+
+#endif // METRICS_H
@@ -0,0 +1,185 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "mplayercommandqueue.h"
+#include "metrics.h"
+
+// pausedはmplayerが一時停止中かどうか。
+// 一時停止中にpausing系の接頭辞が無いコマンドを送ると再生が再開してしまう為、
+// 一時停止を操作するコマンド以外にはpausing_keep_forceを付ける。
+void MplayerCommandQueue::push(const QString& command, bool paused)
+{
+    Command c;
+    int pos = 0;
+
+    // 接頭辞とコマンド名だけを切り出し、残りは引数としてそのまま持つ
+    for(;;) {
+        while( pos < command.size() && command[pos] == ' ' )
+            ++pos;
+
+        int end = command.indexOf(' ', pos);
+        if( end == -1 )
+            end = command.size();
+
+        QString word = command.mid(pos, end - pos);
+        pos = end + 1;
+
+        if( word.isEmpty() )
+            return;
+
+        if( c.prefix.isEmpty() && word.startsWith("pausing") )
+            c.prefix = word;
+        else {
+            c.name = word;
+            break;
+        }
+    }
+
+    if( pos < command.size() )
+        c.args = command.mid(pos);
+
+    c.queuedTime = Metrics::now();
+
+    // ファイルを切り替えるコマンドは、次のファイルを一時停止状態で始めないよう除く
+    if( c.prefix.isEmpty() && paused && !controlsPause(c.name)
+        && c.name != "loadfile" && c.name != "stop" )
+    {
+        c.prefix = "pausing_keep_force";
+    }
+
+    int i;
+    if( c.name == "seek" )
+        i = mergeSeek(&c);
+    else
+        i = findSuperseded(c);
+
+    // 置き換える場合は前のコマンドの位置に入れ、他のコマンドとの順序を保つ
+    if( i != -1 ) {
+        c.queuedTime = _commands[i].queuedTime;
+        _commands[i] = c;
+        Metrics::count("mplayer.command.merged");
+    }
+    else
+        _commands.append(c);
+}
+
+// 待ち行列の全コマンドを改行区切りで連結して取り出す
+QByteArray MplayerCommandQueue::takeAll()
+{
+    QByteArray bytes;
+    qint64 now = Metrics::now();
+
+    foreach(const Command& c, _commands) {
+        QString line = c.name;
+        if( !c.prefix.isEmpty() )
+            line.prepend(c.prefix + " ");
+
+        if( !c.args.isEmpty() )
+            line += " " + c.args;
+
+        bytes += line.toLocal8Bit() + "\n";
+
+        Metrics::sample("mplayer.command.latency_ms", (now - c.queuedTime) / 1000.0);
+    }
+
+    Metrics::sample("mplayer.command.queue_depth", _commands.size());
+    Metrics::count("mplayer.command.written", _commands.size());
+
+    _commands.clear();
+    return bytes;
+}
+
+// commandで置き換えられるコマンドを後ろから探す。一時停止等の操作を越えては探さない
+int MplayerCommandQueue::findSuperseded(const Command& command) const
+{
+    if( !isAbsoluteSetting(command) )
+        return -1;
+
+    for(int i=_commands.size()-1; i >= 0; --i) {
+        const Command& old = _commands[i];
+        if( old.name == command.name ) {
+            if( command.name != "set_property" || arg(old, 0) == arg(command, 0) )
+                return i;
+        }
+
+        if( isBarrier(old.name) )
+            break;
+    }
+
+    return -1;
+}
+
+// 新しいシークが絶対位置指定の場合は前のシークを置き換える。
+// 相対シーク同士の場合は移動量を合算する。置き換える前のシークの位置を返す
+int MplayerCommandQueue::mergeSeek(Command* command) const
+{
+    for(int i=_commands.size()-1; i >= 0; --i) {
+        const Command& old = _commands[i];
+        if( old.name == "seek" ) {
+            int type    = arg(*command, 1).toInt();
+            int oldType = arg(old, 1).toInt();
+
+            if( type != 0 )
+                return i;
+
+            if( oldType == 0 ) {
+                double value = arg(old, 0).toDouble() + arg(*command, 0).toDouble();
+                command->args = QString().sprintf("%.1f 0", value);
+                return i;
+            }
+
+            return -1;
+        }
+
+        if( isBarrier(old.name) )
+            break;
+    }
+
+    return -1;
+}
+
+// 空白区切りのindex番目の引数。無い場合は空文字列(数値としては0)
+QString MplayerCommandQueue::arg(const Command& command, int index)
+{
+    return command.args.section(' ', index, index, QString::SectionSkipEmpty);
+}
+
+// 前の同じ種類のコマンドの結果を上書きする、値を設定するコマンドか
+bool MplayerCommandQueue::isAbsoluteSetting(const Command& command)
+{
+    const QString& name = command.name;
+
+    if( name == "volume" || name == "contrast" || name == "brightness"
+     || name == "saturation" || name == "hue" || name == "gamma" )
+    {
+        // 第2引数が1の場合のみ絶対値指定
+        return arg(command, 1) == "1";
+    }
+
+    if( name == "set_property" )
+        return !command.args.isEmpty();
+
+    return name == "speed_set" || name == "osd_show_text" || name == "osd_show_property_text";
+}
+
+bool MplayerCommandQueue::isBarrier(const QString& name)
+{
+    return controlsPause(name) || name == "loadfile" || name == "stop";
+}
+
+bool MplayerCommandQueue::controlsPause(const QString& name)
+{
+    return name == "pause" || name == "frame_step" || name == "quit";
+}
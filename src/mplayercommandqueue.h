@@ -0,0 +1,55 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MPLAYERCOMMANDQUEUE_H
+#define MPLAYERCOMMANDQUEUE_H
+
+#include <QString>
+#include <QList>
+#include <QByteArray>
+
+// mplayerへ送るスレーブコマンドの待ち行列。
+// 同じ種類の値を設定するコマンドは前のコマンドの位置で後のコマンドに置き換え、
+// まとめて1回で書き込む。
+class MplayerCommandQueue
+{
+public:
+    void       push(const QString& command, bool paused);
+    QByteArray takeAll();
+    void       clear()         { _commands.clear(); }
+    bool       isEmpty() const { return _commands.isEmpty(); }
+    int        size() const    { return _commands.size(); }
+
+private:
+    struct Command {
+        QString prefix;     // pausing_keep_force等
+        QString name;
+        QString args;       // 引数部分。引用符内の空白を崩さない様、そのまま保持する
+        qint64  queuedTime;
+    };
+
+    int  findSuperseded(const Command& command) const;
+    int  mergeSeek(Command* command) const;
+
+    static QString arg(const Command& command, int index);
+
+    static bool isAbsoluteSetting(const Command& command);
+    static bool isBarrier(const QString& name);
+    static bool controlsPause(const QString& name);
+
+    QList<Command> _commands;
+};
+
+#endif // MPLAYERCOMMANDQUEUE_H
@@ -0,0 +1,149 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string.h>
+#include "mplayerline.h"
+
+namespace {
+
+struct Prefix
+{
+    const char*       str;
+    MplayerLine::TYPE type;
+};
+
+// 先頭文字毎にまとめて並べる
+const Prefix s_prefixes[] = {
+    { " title: ",               MplayerLine::TYPE_CLIP_TITLE },
+    { " author: ",              MplayerLine::TYPE_CLIP_AUTHOR },
+    { " copyright: ",           MplayerLine::TYPE_CLIP_COPYRIGHT },
+    { " comments: ",            MplayerLine::TYPE_CLIP_COMMENTS },
+    { "***",                    MplayerLine::TYPE_SCREENSHOT },
+    { "ANS_TIME_POSITION=",     MplayerLine::TYPE_ANS_TIME_POSITION },
+    { "ANS_pause=",             MplayerLine::TYPE_ANS_PAUSE },
+    { "ANS_time_pos=",          MplayerLine::TYPE_ANS_TIME_POS },
+    { "Audio: no sound",        MplayerLine::TYPE_NO_AUDIO },
+    { "Cache fill:",            MplayerLine::TYPE_CACHE_FILL },
+    { "Cache empty",            MplayerLine::TYPE_CACHE_UNDERRUN },
+    { "Cache not filling",      MplayerLine::TYPE_CACHE_UNDERRUN },
+    { "Cache size set to",      MplayerLine::TYPE_CACHE_SIZE },
+    { "Connecting to",          MplayerLine::TYPE_CONNECTING },
+    { "Detected file format: ", MplayerLine::TYPE_FILE_FORMAT },
+    { "EOF code:",              MplayerLine::TYPE_EOF_CODE },
+    { "Generating Index:",      MplayerLine::TYPE_GENERATING_INDEX },
+    { "ID_PAUSED",              MplayerLine::TYPE_PAUSED },
+    { "ID_LENGTH=",             MplayerLine::TYPE_LENGTH },
+    { "ID_SEEKABLE=",           MplayerLine::TYPE_SEEKABLE },
+    { "ID_EXIT=EOF",            MplayerLine::TYPE_EXIT_EOF },
+    { "ID_FILENAME=",           MplayerLine::TYPE_FILENAME },
+    { "Starting playback...",   MplayerLine::TYPE_STARTING_PLAYBACK },
+    { "VO: ",                   MplayerLine::TYPE_VIDEO_OUTPUT },
+    { "Video: no video",        MplayerLine::TYPE_NO_VIDEO },
+};
+
+const int PREFIX_COUNT = sizeof(s_prefixes) / sizeof(s_prefixes[0]);
+
+// 先頭文字からs_prefixesの探索範囲を引く索引
+class PrefixIndex
+{
+public:
+    PrefixIndex()
+    {
+        memset(_begin, 0, sizeof(_begin));
+        memset(_end, 0, sizeof(_end));
+
+        for(int i=0; i < PREFIX_COUNT; ++i) {
+            uchar c = s_prefixes[i].str[0];
+            if( _end[c] == 0 )
+                _begin[c] = i;
+
+            _end[c] = i + 1;
+        }
+    }
+
+    int begin(ushort c) const { return c < 128 ? _begin[c] : 0; }
+    int end(ushort c) const   { return c < 128 ? _end[c] : 0; }
+
+private:
+    int _begin[128];
+    int _end[128];
+};
+
+const PrefixIndex s_prefixIndex;
+
+struct Suffix
+{
+    const char*       str;
+    const char*       contains;     // NULLでない場合、この文字列も含む行のみ
+    MplayerLine::TYPE type;
+};
+
+// 先頭が固定されていない行。末尾の文字が重ならない様に並べる
+const Suffix s_suffixes[] = {
+    { " file format detected.", NULL,               MplayerLine::TYPE_FILE_FORMAT },
+    { " for writing!",          " Error opening ",  MplayerLine::TYPE_SCREENSHOT_ERROR },
+};
+
+const int SUFFIX_COUNT = sizeof(s_suffixes) / sizeof(s_suffixes[0]);
+
+// 末尾の文字からs_suffixesの要素を引く索引
+class SuffixIndex
+{
+public:
+    SuffixIndex()
+    {
+        memset(_suffixes, 0, sizeof(_suffixes));
+
+        for(int i=0; i < SUFFIX_COUNT; ++i) {
+            const char* str = s_suffixes[i].str;
+            _suffixes[(uchar)str[strlen(str) - 1]] = &s_suffixes[i];
+        }
+    }
+
+    const Suffix* find(ushort c) const { return c < 128 ? _suffixes[c] : NULL; }
+
+private:
+    const Suffix* _suffixes[128];
+};
+
+const SuffixIndex s_suffixIndex;
+
+}
+
+MplayerLine::TYPE MplayerLine::type(const QString& line)
+{
+    if( line.isEmpty() )
+        return TYPE_UNKNOWN;
+
+    ushort c = line[0].unicode();
+    for(int i=s_prefixIndex.begin(c); i < s_prefixIndex.end(c); ++i) {
+        if( line.startsWith(QLatin1String(s_prefixes[i].str)) )
+            return s_prefixes[i].type;
+    }
+
+    // 先頭が固定されていない行は末尾の文字で絞り込み、一致しない行は文字列を探さない
+    const Suffix* suffix = s_suffixIndex.find(line[line.size() - 1].unicode());
+    if( suffix != NULL && line.endsWith(QLatin1String(suffix->str))
+        && (suffix->contains == NULL || line.contains(QLatin1String(suffix->contains))) )
+    {
+        return suffix->type;
+    }
+
+    // libavcodecのメッセージは"[デコーダ名 @ アドレス]"で始まる
+    if( c == '[' && line.contains(QLatin1String("Bits overconsumption:")) )
+        return TYPE_CACHE_UNDERRUN;
+
+    return TYPE_UNKNOWN;
+}
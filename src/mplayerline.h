@@ -0,0 +1,57 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MPLAYERLINE_H
+#define MPLAYERLINE_H
+
+#include <QString>
+
+// mplayerの出力行(ステータス行以外)の種類を、行の先頭文字列から判定する
+class MplayerLine
+{
+public:
+    enum TYPE {
+        TYPE_UNKNOWN,
+        TYPE_CACHE_UNDERRUN,        // Cache empty, Cache not filling, Bits overconsumption
+        TYPE_STARTING_PLAYBACK,     // Starting playback...
+        TYPE_VIDEO_OUTPUT,          // VO: [driver] WxH => WxH
+        TYPE_PAUSED,                // ID_PAUSED
+        TYPE_CONNECTING,            // Connecting to
+        TYPE_CACHE_SIZE,            // Cache size set to
+        TYPE_CACHE_FILL,            // Cache fill:
+        TYPE_GENERATING_INDEX,      // Generating Index:
+        TYPE_LENGTH,                // ID_LENGTH=
+        TYPE_SEEKABLE,              // ID_SEEKABLE=
+        TYPE_CLIP_TITLE,            //  title:
+        TYPE_CLIP_AUTHOR,           //  author:
+        TYPE_CLIP_COPYRIGHT,        //  copyright:
+        TYPE_CLIP_COMMENTS,         //  comments:
+        TYPE_NO_VIDEO,              // Video: no video
+        TYPE_NO_AUDIO,              // Audio: no sound
+        TYPE_FILE_FORMAT,           // Detected file format:, ... file format detected.
+        TYPE_EXIT_EOF,              // ID_EXIT=EOF
+        TYPE_SCREENSHOT,            // *** screenshot '
+        TYPE_SCREENSHOT_ERROR,      // ... Error opening ... for writing!
+        TYPE_ANS_TIME_POSITION,     // ANS_TIME_POSITION=
+        TYPE_ANS_PAUSE,             // ANS_pause=
+        TYPE_ANS_TIME_POS,          // ANS_time_pos= (get_property time_pos)
+        TYPE_FILENAME,              // ID_FILENAME=
+        TYPE_EOF_CODE,              // EOF code: (-msglevel global=6の場合)
+    };
+
+    static TYPE type(const QString& line);
+};
+
+#endif // MPLAYERLINE_H
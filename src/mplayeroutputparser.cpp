@@ -0,0 +1,223 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QRegExp>
+#include "mplayeroutputparser.h"
+#include "mplayerline.h"
+
+MplayerOutputParser::MplayerOutputParser(QObject* parent) : QObject(parent)
+{
+    reset();
+}
+
+// 再生開始前に呼ぶ
+void MplayerOutputParser::reset()
+{
+    _existVideo = true;
+    _existAudio = true;
+    _paused = false;
+}
+
+void MplayerOutputParser::parseLine(const QString& line, qint64 receivedTime)
+{
+//  static QRegExp rxCacheSize("^Cache size set to (\\d+)");
+    static QRegExp rxCacheFill("^Cache fill: *([0-9.]+)%");
+    static QRegExp rxGenIndex("^Generating Index: *(\\d+)");
+    static QRegExp rxFileFormat("^(.+) file format detected.|^Detected file format: (.+)");
+//  static QRegExp rxVideoW("^ID_VIDEO_WIDTH=(\\d+)");
+//  static QRegExp rxVideoH("^ID_VIDEO_HEIGHT=(\\d+)");
+    static QRegExp rxVideoDriverWH("^VO: \\[(.+)\\] \\d+x\\d+ => (\\d+)x(\\d+)");
+    static QRegExp rxLength("^ID_LENGTH=([0-9.]+)");
+    static QRegExp rxSeekable("^ID_SEEKABLE=(\\d)");
+//  static QRegExp rxStartTime("^ID_START_TIME=([0-9.]+)");
+    static QRegExp rxTitle("^ title: (.+)");
+    static QRegExp rxAuthor("^ author: (.+)");
+    static QRegExp rxCopyright("^ copyright: (.+)");
+    static QRegExp rxComments("^ comments: (.+)");
+    static QRegExp rxScreenshot("^\\*\\*\\* screenshot '(.+)'");
+
+    MplayerStatus status;
+    if( MplayerStatus::parse(line, &status) ) {
+        status.receivedTime = receivedTime;
+        _paused = false;
+        emit statusTick(status, line);
+        return;
+    }
+
+    MplayerLine::TYPE lineType = MplayerLine::type(line);
+
+    // 問い合わせモードの応答はステータス行と同様にログ出力しない。
+    // get_time_posの応答はステータス行として扱い、
+    // 一時停止中の応答は再生の再開と誤認しないよう無視する
+    if( lineType == MplayerLine::TYPE_ANS_TIME_POSITION ) {
+        if( !_paused ) {
+            status.time = line.mid(line.indexOf('=') + 1).toDouble();
+            status.timeVo = status.time;
+            status.avDelay = 0;
+            status.frame = -1;
+            status.droppedFrames = -1;
+            status.hasAudio = _existAudio;
+            status.hasVideo = _existVideo;
+            status.receivedTime = receivedTime;
+
+            emit statusTick(status, line);
+        }
+        return;
+    }
+
+    if( lineType == MplayerLine::TYPE_ANS_TIME_POS ) {
+        emit timePosAnswered(line.mid(line.indexOf('=') + 1).toDouble());
+        return;
+    }
+
+    if( lineType == MplayerLine::TYPE_ANS_PAUSE ) {
+        if( line.endsWith(QLatin1String("yes")) ) {
+            if( !_paused ) {
+                _paused = true;
+                emit paused();
+            }
+        }
+        else
+            _paused = false;
+
+        return;
+    }
+
+    emit messageLine(line);
+
+    switch( lineType ) {
+    case MplayerLine::TYPE_CACHE_UNDERRUN:
+        emit cacheUnderrun();
+        break;
+
+    case MplayerLine::TYPE_STARTING_PLAYBACK:
+        if( !_existVideo )
+            emit videoOutputReady(QString(), QSize());
+        break;
+
+    case MplayerLine::TYPE_VIDEO_OUTPUT:
+        if( rxVideoDriverWH.indexIn(line) != -1 ) {
+            if( _existVideo ) {
+                emit videoOutputReady(rxVideoDriverWH.cap(1),
+                        QSize(rxVideoDriverWH.cap(2).toInt(), rxVideoDriverWH.cap(3).toInt()));
+            }
+            else
+                emit videoOutputReady(QString(), QSize());
+        }
+        break;
+
+    case MplayerLine::TYPE_PAUSED:
+        _paused = true;
+        emit paused();
+        break;
+
+
+    case MplayerLine::TYPE_CONNECTING:
+        emit connecting();
+        break;
+
+    case MplayerLine::TYPE_CACHE_SIZE:
+        emit cacheSizeSet();
+        break;
+
+    case MplayerLine::TYPE_CACHE_FILL:
+        if( rxCacheFill.indexIn(line) != -1 )
+            emit cacheFill(rxCacheFill.cap(1).toDouble());
+        break;
+
+    case MplayerLine::TYPE_GENERATING_INDEX:
+        if( rxGenIndex.indexIn(line) != -1 )
+            emit generatingIndex(rxGenIndex.cap(1).toInt());
+        break;
+
+    case MplayerLine::TYPE_LENGTH:
+        if( rxLength.indexIn(line) != -1 )
+            emit identifyInfo(INFO_LENGTH, rxLength.cap(1));
+        break;
+
+    case MplayerLine::TYPE_SEEKABLE:
+        if( rxSeekable.indexIn(line) != -1 )
+            emit identifyInfo(INFO_SEEKABLE, rxSeekable.cap(1));
+        break;
+
+    case MplayerLine::TYPE_CLIP_TITLE:
+        if( rxTitle.indexIn(line) != -1 )
+            emit identifyInfo(INFO_CLIP_TITLE, rxTitle.cap(1));
+        break;
+
+    case MplayerLine::TYPE_CLIP_AUTHOR:
+        if( rxAuthor.indexIn(line) != -1 )
+            emit identifyInfo(INFO_CLIP_AUTHOR, rxAuthor.cap(1));
+        break;
+
+    case MplayerLine::TYPE_CLIP_COPYRIGHT:
+        if( rxCopyright.indexIn(line) != -1 )
+            emit identifyInfo(INFO_CLIP_COPYRIGHT, rxCopyright.cap(1));
+        break;
+
+    case MplayerLine::TYPE_CLIP_COMMENTS:
+        if( rxComments.indexIn(line) != -1 )
+            emit identifyInfo(INFO_CLIP_COMMENTS, rxComments.cap(1));
+        break;
+
+    case MplayerLine::TYPE_NO_VIDEO:
+        _existVideo = false;
+        emit identifyInfo(INFO_NO_VIDEO, QString());
+        break;
+
+    case MplayerLine::TYPE_NO_AUDIO:
+        _existAudio = false;
+        emit identifyInfo(INFO_NO_AUDIO, QString());
+        break;
+
+    case MplayerLine::TYPE_FILE_FORMAT:
+        if( rxFileFormat.indexIn(line) != -1 ) {
+            QString format = rxFileFormat.cap(1);
+            if( format.size() == 0 )
+                format = rxFileFormat.cap(2);
+
+            emit identifyInfo(INFO_FILE_FORMAT, format);
+        }
+        break;
+
+//  case MplayerLine::TYPE_EXIT_QUIT:
+//      break;
+    case MplayerLine::TYPE_EXIT_EOF:
+        emit eof();
+        break;
+
+    // -idleの場合は1つのプロセスで複数のファイルを再生するので、ファイル毎に状態を戻す
+    case MplayerLine::TYPE_FILENAME:
+        reset();
+        emit fileStarted();
+        break;
+
+    case MplayerLine::TYPE_EOF_CODE:
+        emit fileEnded(line.mid(line.indexOf(':') + 1).trimmed().toInt());
+        break;
+
+    case MplayerLine::TYPE_SCREENSHOT:
+        if( rxScreenshot.indexIn(line) != -1 )
+            emit screenshotSaved(rxScreenshot.cap(1));
+        break;
+
+    case MplayerLine::TYPE_SCREENSHOT_ERROR:
+        emit screenshotFailed();
+        break;
+
+    default:
+        break;
+    }
+}
@@ -0,0 +1,77 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MPLAYEROUTPUTPARSER_H
+#define MPLAYEROUTPUTPARSER_H
+
+#include <QObject>
+#include <QString>
+#include <QSize>
+#include "mplayerstatus.h"
+
+// mplayerの出力行を解析し、種類ごとのシグナルを発行する。
+// ウィジェットには依存しない。
+class MplayerOutputParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum IDENTIFY_INFO {
+        INFO_LENGTH,            // ID_LENGTH=
+        INFO_SEEKABLE,          // ID_SEEKABLE=
+        INFO_FILE_FORMAT,       // file format detected.
+        INFO_CLIP_TITLE,
+        INFO_CLIP_AUTHOR,
+        INFO_CLIP_COPYRIGHT,
+        INFO_CLIP_COMMENTS,
+        INFO_NO_VIDEO,          // Video: no video (valueは空)
+        INFO_NO_AUDIO,          // Audio: no sound (valueは空)
+    };
+
+    MplayerOutputParser(QObject* parent=0);
+
+    void reset();
+    bool existVideo() const { return _existVideo; }
+    bool existAudio() const { return _existAudio; }
+    bool isPaused() const   { return _paused; }
+
+public slots:
+    void parseLine(const QString& line, qint64 receivedTime);
+
+signals:
+    void statusTick(const MplayerStatus& status, const QString& line);
+    void messageLine(const QString& line);          // ステータス行以外の全ての行
+    void identifyInfo(int info, const QString& value);
+    void cacheUnderrun();
+    void connecting();
+    void cacheSizeSet();
+    void cacheFill(double percent);
+    void generatingIndex(int percent);
+    void videoOutputReady(const QString& videoDriver, const QSize& videoSize); // 映像が無い場合、videoDriverは空
+    void paused();
+    void timePosAnswered(double time);              // get_property time_posの応答。シークの完了確認に使う
+    void eof();
+    void fileStarted();                             // ファイルの読み込みを始めた(ID_FILENAME=)
+    void fileEnded(int code);                       // ファイルの再生を終えた(EOF code:)。1は末尾まで再生
+    void screenshotSaved(const QString& file);
+    void screenshotFailed();
+
+private:
+    bool _existVideo;
+    bool _existAudio;
+    bool _paused;       // ID_PAUSED、ANS_pause=yesを受信し、再生の再開を確認していない
+};
+
+#endif // MPLAYEROUTPUTPARSER_H
@@ -0,0 +1,185 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "mplayerstatus.h"
+
+static inline bool isDigit(const QChar* p)
+{
+    return p->unicode() >= '0' && p->unicode() <= '9';
+}
+
+static inline bool is(const QChar* p, const QChar* end, char c)
+{
+    return p < end && p->unicode() == (ushort)c;
+}
+
+static inline const QChar* skipSpace(const QChar* p, const QChar* end)
+{
+    while( is(p, end, ' ') )
+        ++p;
+
+    return p;
+}
+
+static inline bool startsWith(const QChar* p, const QChar* end, const char* str)
+{
+    for(; *str != '\0'; ++p, ++str) {
+        if( !is(p, end, *str) )
+            return false;
+    }
+
+    return true;
+}
+
+// [0-9.-]+ の数値を読み込む。pは数値の後ろへ進む
+static bool readNumber(const QChar*& p, const QChar* end, double* value)
+{
+    const QChar* begin = p;
+    bool negative = false;
+    double integer = 0;
+    double fraction = 0;
+    double scale = 1;
+    bool point = false;
+
+    for(; p < end; ++p) {
+        ushort c = p->unicode();
+        if( c >= '0' && c <= '9' ) {
+            if( point ) {
+                scale /= 10;
+                fraction += (c - '0') * scale;
+            }
+            else
+                integer = integer*10 + (c - '0');
+        }
+        else
+        if( c == '.' )
+            point = true;
+        else
+        if( c == '-' )
+            negative = true;
+        else
+            break;
+    }
+
+    if( p == begin )
+        return false;
+
+    *value = negative ? -(integer + fraction) : (integer + fraction);
+    return true;
+}
+
+static bool readInt(const QChar*& p, const QChar* end, int* value)
+{
+    const QChar* begin = p;
+    int v = 0;
+
+    for(; p < end && isDigit(p); ++p)
+        v = v*10 + (p->unicode() - '0');
+
+    if( p == begin )
+        return false;
+
+    *value = v;
+    return true;
+}
+
+// ステータス行を1回の走査で解析する。
+// ステータス行でない場合はfalseを返す(statusの内容は不定)。
+bool MplayerStatus::parse(const QChar* line, int size, MplayerStatus* status)
+{
+    const QChar* p   = line;
+    const QChar* end = line + size;
+
+    if( size < 3 || !(is(p, end, 'A') || is(p, end, 'V')) || !is(p+1, end, ':') )
+        return false;
+
+    status->hasAudio = (p->unicode() == 'A');
+    status->hasVideo = !status->hasAudio;
+    status->timeVo = 0;
+    status->avDelay = 0;
+    status->frame = -1;
+    status->droppedFrames = -1;
+
+    p = skipSpace(p + 2, end);
+    if( !readNumber(p, end, &status->time) || !is(p, end, ' ') )
+        return false;
+
+    if( status->hasVideo )
+        status->timeVo = status->time;
+    else
+    if( startsWith(p + 1, end, "V:") ) {
+        const QChar* q = skipSpace(p + 3, end);
+        if( readNumber(q, end, &status->timeVo) ) {
+            status->hasVideo = true;
+            p = q;
+        }
+    }
+
+    // 残りからA-V:と、最後に現れる"フレーム数/ デコード数"を探す
+    const QChar* frameEnd = NULL;
+    while( p < end ) {
+        if( p->unicode() == 'A' && startsWith(p, end, "A-V:") ) {
+            p = skipSpace(p + 4, end);
+            readNumber(p, end, &status->avDelay);
+            continue;
+        }
+
+        if( p->unicode() == '/' && p > line && isDigit(p - 1) ) {
+            const QChar* begin = p - 1;
+            while( begin > line && isDigit(begin - 1) )
+                --begin;
+
+            const QChar* q = skipSpace(p + 1, end);
+            if( begin > line && (begin - 1)->unicode() == ' ' && q < end && isDigit(q) ) {
+                readInt(begin, p, &status->frame);
+                while( q < end && isDigit(q) )
+                    ++q;
+
+                frameEnd = q;
+                p = q;
+                continue;
+            }
+        }
+
+        ++p;
+    }
+
+    // フレーム数の後ろは"cpu% cpu% cpu% ドロップ数 品質 [キャッシュ%]"の順
+    if( frameEnd != NULL ) {
+        p = frameEnd;
+        int percents = 0;
+        while( percents < 3 ) {
+            p = skipSpace(p, end);
+            const QChar* begin = p;
+            while( p < end && p->unicode() != ' ' )
+                ++p;
+
+            if( p == begin || (p - 1)->unicode() != '%' )
+                break;
+
+            ++percents;
+        }
+
+        if( percents == 3 ) {
+            p = skipSpace(p, end);
+            const QChar* q = p;
+            int dropped;
+            if( readInt(q, end, &dropped) && (q == end || q->unicode() == ' ') )
+                status->droppedFrames = dropped;
+        }
+    }
+
+    return true;
+}
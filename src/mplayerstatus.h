@@ -0,0 +1,42 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MPLAYERSTATUS_H
+#define MPLAYERSTATUS_H
+
+#include <QString>
+
+// mplayerのステータス行("A: ... V: ... A-V: ... ct: ... 30/ 30 ...")の解析結果
+struct MplayerStatus
+{
+    double time;            // 先頭の時間(A:、音声が無い場合はV:)
+    double timeVo;          // V:の時間(無い場合は0)
+    double avDelay;         // A-V:の値(無い場合は0)
+    int    frame;           // フレーム数(無い場合は-1)
+    int    droppedFrames;   // ドロップしたフレーム数(無い場合は-1)
+    bool   hasAudio;        // A:で始まる
+    bool   hasVideo;        // V:を含む
+    qint64 receivedTime;    // 行を受信した時刻(Metrics::now()。parse()では設定しない)
+
+    static bool parse(const QString& line, MplayerStatus* status);
+    static bool parse(const QChar* line, int size, MplayerStatus* status);
+};
+
+inline bool MplayerStatus::parse(const QString& line, MplayerStatus* status)
+{
+    return parse(line.constData(), line.size(), status);
+}
+
+#endif // MPLAYERSTATUS_H
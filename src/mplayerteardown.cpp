@@ -0,0 +1,119 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "mplayerteardown.h"
+#include "process.h"
+#include "metrics.h"
+#include "logdialog.h"
+
+MplayerTeardown::MplayerTeardown(MplayerProcess* process, QObject* parent)
+    : QObject(parent)
+{
+    _process = process;
+    _process->setParent(this);
+    _startTime = Metrics::now();
+
+    _timerStage.setSingleShot(true);
+    connect(&_timerStage, SIGNAL(timeout()), this, SLOT(timerStage_timeout()));
+    connect(_process, SIGNAL(finished()), this, SLOT(process_finished()));
+
+    // 起動中の場合はコマンドを受け付けないので、terminate()から始める
+    if( _process->state() == QProcess::Running )
+        enterStage(STAGE_QUIT);
+    else {
+        LogDialog::debug("MplayerTeardown::MplayerTeardown(): process starting", QColor(0,255,0));
+        enterStage(STAGE_TERMINATE);
+    }
+}
+
+// 残りの段階を同期的に行う。アプリケーション終了時用
+void MplayerTeardown::waitForFinished()
+{
+    _timerStage.stop();
+
+    while( _process->state() != QProcess::NotRunning ) {
+        if( _stage == STAGE_ABANDONED )
+            break;
+
+        if( _process->waitForFinished(stageTimeout(_stage)) )
+            break;
+
+        enterStage((STAGE)(_stage + 1));
+        _timerStage.stop();
+    }
+}
+
+void MplayerTeardown::process_finished()
+{
+    _timerStage.stop();
+
+    Metrics::sample("mplayer.teardown.duration_ms", Metrics::elapsedMsec(_startTime));
+    LogDialog::debug(QString("MplayerTeardown::process_finished(): stage %1").arg(_stage));
+
+    emit done();
+
+    _process->disconnect(this);
+    deleteLater();
+}
+
+void MplayerTeardown::timerStage_timeout()
+{
+    if( _stage < STAGE_ABANDONED )
+        enterStage((STAGE)(_stage + 1));
+}
+
+void MplayerTeardown::enterStage(STAGE stage)
+{
+    const QString debugPrefix = "MplayerTeardown::enterStage(): ";
+
+    _stage = stage;
+
+    switch( stage ) {
+    case STAGE_QUIT:
+        Metrics::count("mplayer.teardown.quit");
+        _process->command("quit");
+        break;
+
+    case STAGE_TERMINATE:
+        Metrics::count("mplayer.teardown.terminate");
+        LogDialog::debug(debugPrefix + "terminate()", QColor(255,0,0));
+        _process->terminate();
+        break;
+
+    case STAGE_KILL:
+        Metrics::count("mplayer.teardown.kill");
+        LogDialog::debug(debugPrefix + "kill()", QColor(255,0,0));
+        _process->kill();
+        break;
+
+    case STAGE_ABANDONED:
+    default:
+        Metrics::count("mplayer.teardown.abandoned");
+        LogDialog::debug(debugPrefix + "process does not finish", QColor(255,0,0));
+        return;
+    }
+
+    _timerStage.start(stageTimeout(stage));
+}
+
+int MplayerTeardown::stageTimeout(STAGE stage)
+{
+    switch( stage ) {
+    case STAGE_QUIT:      return 1000;
+    case STAGE_TERMINATE: return 3000;
+    case STAGE_KILL:      return 2000;
+    default:              return 0;
+    }
+}
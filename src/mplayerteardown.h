@@ -0,0 +1,61 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MPLAYERTEARDOWN_H
+#define MPLAYERTEARDOWN_H
+
+#include <QObject>
+#include <QTimer>
+
+class MplayerProcess;
+
+// 切り離したmplayerプロセスを、呼び出し元を待たせずに終了させる。
+// quit、terminate()、kill()の順に段階を進め、各段階で一定時間終了を待つ。
+// プロセスの終了後は、プロセスと共に自身を削除する。
+class MplayerTeardown : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum STAGE {
+        STAGE_QUIT,         // quitコマンドを送った
+        STAGE_TERMINATE,    // terminate()した
+        STAGE_KILL,         // kill()した
+        STAGE_ABANDONED,    // kill()後も終了しない。終了の通知のみ待つ
+    };
+
+    MplayerTeardown(MplayerProcess* process, QObject* parent);
+
+    STAGE stage() const { return _stage; }
+    void  waitForFinished();
+
+signals:
+    void done();
+
+private slots:
+    void process_finished();
+    void timerStage_timeout();
+
+private:
+    void enterStage(STAGE stage);
+    static int stageTimeout(STAGE stage);
+
+    MplayerProcess* _process;
+    STAGE           _stage;
+    QTimer          _timerStage;
+    qint64          _startTime;
+};
+
+#endif // MPLAYERTEARDOWN_H
@@ -0,0 +1,542 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QTimer>
+#include "mplayerworker.h"
+#include "mplayeroutputparser.h"
+#include "mplayerteardown.h"
+#include "process.h"
+#include "metrics.h"
+
+MplayerWorker::MplayerWorker() : QObject(0)
+{
+    _process = NULL;
+    _parser = NULL;
+    _timerPoll = NULL;
+    _pollInterval = 0;
+    _state = QProcess::NotRunning;
+    _flushScheduled = false;
+    _batchOpen = false;
+    _lastFrame = 0;
+    _lagBaseValid = false;
+    _lagBase = 0;
+    _lagLastTime = 0;
+    _idle = false;
+    _fileOpen = false;
+    _awaitFileStart = false;
+    _queuedFile = false;
+    _idleReady = 0;
+}
+
+// ワーカースレッドで呼ぶ
+void MplayerWorker::init()
+{
+    _parser = new MplayerOutputParser(this);
+    _timerPoll = new QTimer(this);
+
+    connect(_parser,  SIGNAL(statusTick(const MplayerStatus&, const QString&)),
+            this,     SLOT(parser_statusTick(const MplayerStatus&, const QString&)));
+    connect(_parser,  SIGNAL(videoOutputReady(const QString&, const QSize&)),
+            this,     SLOT(parser_videoOutputReady()));
+    connect(_parser,  SIGNAL(identifyInfo(int, const QString&)),
+            this,     SLOT(parser_identifyInfo(int)));
+    connect(_parser,  SIGNAL(messageLine(const QString&)),
+            this,     SLOT(closeStatusBatch()));
+    connect(_parser,  SIGNAL(paused()),
+            this,     SLOT(closeStatusBatch()));
+    connect(_parser,  SIGNAL(timePosAnswered(double)),
+            this,     SLOT(closeStatusBatch()));
+    connect(_parser,  SIGNAL(paused()),
+            this,     SLOT(resetArrivalLag()));
+    connect(_parser,  SIGNAL(cacheUnderrun()),
+            this,     SLOT(resetArrivalLag()));
+    connect(_parser,  SIGNAL(fileStarted()),
+            this,     SLOT(parser_fileStarted()));
+    connect(_parser,  SIGNAL(fileEnded(int)),
+            this,     SLOT(parser_fileEnded(int)));
+    connect(_timerPoll, SIGNAL(timeout()), this, SLOT(pollStatus()));
+}
+
+// ワーカースレッドで呼ぶ
+void MplayerWorker::cleanup()
+{
+    terminate();
+
+    // アプリケーション終了時は、終了処理中のプロセスの終了を待つ
+    foreach(MplayerTeardown* teardown, findChildren<MplayerTeardown*>())
+        teardown->waitForFinished();
+
+    delete _timerPoll;
+    delete _parser;
+    _timerPoll = NULL;
+    _process = NULL;
+    _parser = NULL;
+}
+
+void MplayerWorker::start(const QString& program, const QStringList& arguments)
+{
+    _commandQueue.clear();
+
+    createProcess();
+    resetFile();
+    _idle = arguments.contains("-idle");
+    _startupTrace.begin("process", Metrics::now());
+    _process->start(program, arguments, QIODevice::ReadWrite);
+    if( _process->waitForStarted() )
+        _startupTrace.mark(StartupTrace::STAGE_SPAWN, Metrics::now());
+}
+
+// -idleで起動したプロセスに次のファイルを読み込ませる
+void MplayerWorker::loadFile(const QString& path)
+{
+    if( !_idle || _process == NULL || _process->state() != QProcess::Running )
+        return;
+
+    resetFile();
+    _startupTrace.begin("loadfile", Metrics::now());
+    command(QString("loadfile \"%1\" 0").arg(path));
+}
+
+// -idleで起動したプロセスの再生リストへファイルを追加する。
+// 再生中のファイルが末尾に達すると、mplayerは続けて追加したファイルを再生する
+void MplayerWorker::queueFile(const QString& path)
+{
+    if( !_idle || !_fileOpen || _process == NULL || _process->state() != QProcess::Running )
+        return;
+
+    command(QString("loadfile \"%1\" 1").arg(path));
+    _queuedFile = true;
+}
+
+// -idleで起動したプロセスの場合は再生のみを停止し、プロセスは次のloadFile()の為に残す。
+// それ以外はterminate()と同じ
+void MplayerWorker::stopFile()
+{
+    if( !_idle || _process == NULL || _process->state() != QProcess::Running ) {
+        terminate();
+        return;
+    }
+
+    command("stop");
+    flushCommands();
+
+    // 停止したファイルのEOF code:は、次のファイルの開始までに出力されるので無視する
+    _awaitFileStart = true;
+    endFile();
+}
+
+// 現在のプロセスを切り離し、終了はMplayerTeardownに任せて直ちに戻る。
+// 切り離したプロセスの出力は解析しない。
+// 実行中だった場合は、プレーヤ側から見たプロセスの終了としてここでfinished()を発行する
+// (終了処理中に次のプロセスを起動しても、古いプロセスのfinished()を受け取らないようにする)。
+void MplayerWorker::terminate()
+{
+    if( _process == NULL )
+        return;
+
+    flushCommands();
+    _timerPoll->stop();
+
+    MplayerProcess* process = _process;
+    _process = NULL;
+    process->disconnect(this);
+    process->disconnect(_parser);
+    _startupTrace.cancel();
+    _state.fetchAndStoreOrdered(QProcess::NotRunning);
+    _idleReady.fetchAndStoreOrdered(0);
+
+    bool fileOpen = _fileOpen;
+    _fileOpen = false;
+    _queuedFile = false;
+
+    if( process->state() == QProcess::NotRunning ) {
+        delete process;
+        return;
+    }
+
+    new MplayerTeardown(process, this);
+    if( fileOpen )
+        emit finished();
+}
+
+// コマンドは待ち行列に入れ、イベントループの次の周回でまとめて書き込む
+void MplayerWorker::command(const QString& command)
+{
+    _commandQueue.push(command, _parser->isPaused());
+
+    if( command.contains("speed_") ) // 再生速度が変わると時間の進みも変わる
+        resetArrivalLag();
+
+    if( !_flushScheduled ) {
+        _flushScheduled = true;
+        QMetaObject::invokeMethod(this, "flushCommands", Qt::QueuedConnection);
+    }
+}
+
+void MplayerWorker::flushCommands()
+{
+    _flushScheduled = false;
+
+    if( _commandQueue.isEmpty() )
+        return;
+
+    if( _process != NULL && _process->state() != QProcess::NotRunning )
+        _process->write(_commandQueue.takeAll());
+    else
+        _commandQueue.clear();
+}
+
+void MplayerWorker::receiveMplayerChildProcess()
+{
+    if( _process != NULL )
+        _process->receiveMplayerChildProcess();
+}
+
+// 0より大きい場合、再生開始後にmsec間隔でmplayerへ再生状態を問い合わせる。
+// mplayerは-quietで起動し、ステータス行を出力させない事を前提とする
+void MplayerWorker::setPollInterval(int msec)
+{
+    _pollInterval = msec;
+
+    if( _pollInterval <= 0 )
+        _timerPoll->stop();
+    else
+    if( _timerPoll->isActive() )
+        _timerPoll->start(_pollInterval);
+}
+
+// GUIスレッドから呼ぶ。集約結果を古い順に1つ取り出す
+bool MplayerWorker::takeStatusBatch(MplayerStatusBatch* batch)
+{
+    QMutexLocker locker(&_mutex);
+
+    if( _batches.isEmpty() )
+        return false;
+
+    *batch = _batches.takeFirst();
+    if( _batches.isEmpty() )
+        _batchOpen = false;
+
+    return true;
+}
+
+void MplayerWorker::process_stateChanged(QProcess::ProcessState state)
+{
+    _state.fetchAndStoreOrdered(state);
+
+    if( state == QProcess::NotRunning ) {
+        _timerPoll->stop();
+        _idleReady.fetchAndStoreOrdered(0);
+    }
+}
+
+void MplayerWorker::process_finished()
+{
+    if( _fileOpen ) {
+        _fileOpen = false;
+        emit finished();
+    }
+}
+
+void MplayerWorker::process_outputLine(const QString&, qint64 receivedTime)
+{
+    _startupTrace.mark(StartupTrace::STAGE_FIRST_OUTPUT, receivedTime);
+}
+
+void MplayerWorker::parser_fileStarted()
+{
+    _awaitFileStart = false;
+}
+
+// -idleの場合、ファイルの再生終了をプレーヤ側から見たプロセスの終了として通知する
+void MplayerWorker::parser_fileEnded(int code)
+{
+    if( !_idle || _awaitFileStart )
+        return;
+
+    if( code == 1 && _queuedFile ) { // 追加したファイルの再生へ移る
+        resetFile();
+        _startupTrace.begin("queued", Metrics::now());
+        emit queuedFileStarted();
+        return;
+    }
+
+    if( code == 1 ) // 末尾まで再生した
+        emit eof();
+
+    endFile();
+}
+
+// 再生開始前の問い合わせはmplayerのコマンドバッファに溜まるだけなので、
+// 問い合わせは再生開始後に始める
+void MplayerWorker::parser_videoOutputReady()
+{
+    _startupTrace.mark(StartupTrace::STAGE_VIDEO_OUTPUT, Metrics::now());
+
+    if( _pollInterval > 0 && !_timerPoll->isActive() )
+        _timerPoll->start(_pollInterval);
+}
+
+void MplayerWorker::parser_identifyInfo(int info)
+{
+    if( info == MplayerOutputParser::INFO_FILE_FORMAT )
+        _startupTrace.mark(StartupTrace::STAGE_FILE_FORMAT, Metrics::now());
+}
+
+void MplayerWorker::pollStatus()
+{
+    command("pausing_keep_force get_property pause");
+    command("pausing_keep_force get_time_pos");
+}
+
+// ステータス行はGUIスレッドが受け取るまで1つに集約する。
+// ステータス行以外の行や一時停止との順序を保つ為、それらを受信した後は新しい集約を始める。
+// また、時間が1秒以上飛んだ場合も新しい集約を始める(PurePlayerの時間ズレ検出用)。
+void MplayerWorker::parser_statusTick(const MplayerStatus& status, const QString& line)
+{
+    measureArrivalLag(status);
+    _startupTrace.mark(StartupTrace::STAGE_FIRST_STATUS, status.receivedTime);
+
+    int frameCount = 0;
+    if( status.frame >= 0 ) {
+        uint currentFrame = status.frame;
+        if( currentFrame==0 || currentFrame!=_lastFrame ) {
+            frameCount = 1;
+            _lastFrame = currentFrame;
+        }
+    }
+
+    QMutexLocker locker(&_mutex);
+
+    if( _batchOpen && status.time - _batches.last().last.time <= 1 ) {
+        MplayerStatusBatch& batch = _batches.last();
+        batch.last = status;
+        batch.count += 1;
+        batch.frameCount += frameCount;
+        batch.lastLine = line;
+        return;
+    }
+
+    MplayerStatusBatch batch;
+    batch.first = status;
+    batch.last = status;
+    batch.count = 1;
+    batch.frameCount = frameCount;
+    batch.lastLine = line;
+    _batches.append(batch);
+    _batchOpen = true;
+
+    locker.unlock();
+    emit statusBatchReady();
+}
+
+// ファイル毎の状態を戻す
+void MplayerWorker::resetFile()
+{
+    _parser->reset();
+    _lastFrame = 0;
+    _lagBaseValid = false;
+    _timerPoll->stop();
+
+    QMutexLocker locker(&_mutex);
+    _batches.clear();
+    _batchOpen = false;
+    locker.unlock();
+
+    _fileOpen = true;
+    _awaitFileStart = true;
+    _queuedFile = false;
+    _idleReady.fetchAndStoreOrdered(0);
+}
+
+// stopコマンドや再生リストの末尾で、mplayerの再生リストは空になる
+void MplayerWorker::endFile()
+{
+    _startupTrace.cancel();
+    _timerPoll->stop();
+    _queuedFile = false;
+
+    if( !_fileOpen )
+        return;
+
+    _fileOpen = false;
+    _idleReady.fetchAndStoreOrdered(1);
+    emit finished();
+}
+
+// 前回のプロセスが残っていれば削除し、新しいプロセスを作る
+void MplayerWorker::createProcess()
+{
+    terminate();
+
+    _process = new MplayerProcess(this);
+    connect(_process, SIGNAL(stateChanged(QProcess::ProcessState)),
+            this,     SLOT(process_stateChanged(QProcess::ProcessState)));
+    // 解析より先に受信を記録する
+    connect(_process, SIGNAL(outputLine(const QString&, qint64)),
+            this,     SLOT(process_outputLine(const QString&, qint64)));
+    connect(_process, SIGNAL(outputLine(const QString&, qint64)),
+            _parser,  SLOT(parseLine(const QString&, qint64)));
+    connect(_process, SIGNAL(finished()),
+            this,     SLOT(process_finished()));
+    connect(_process, SIGNAL(error(QProcess::ProcessError)),
+            this,     SIGNAL(error(QProcess::ProcessError)));
+}
+
+void MplayerWorker::closeStatusBatch()
+{
+    QMutexLocker locker(&_mutex);
+    _batchOpen = false;
+}
+
+void MplayerWorker::resetArrivalLag()
+{
+    _lagBaseValid = false;
+}
+
+// 受信時刻の進みとmplayerが出力した時間の進みの差を、行の到着遅れとして記録する。
+// 基準は(受信時刻 - 時間)の最小値とし、時間が飛んだ場合や一時停止後は基準を取り直す
+void MplayerWorker::measureArrivalLag(const MplayerStatus& status)
+{
+    double offset = status.receivedTime / 1000.0 - status.time * 1000; // ms
+
+    if( !_lagBaseValid || qAbs(status.time - _lagLastTime) > 1 || offset < _lagBase ) {
+        _lagBase = offset;
+        _lagBaseValid = true;
+    }
+
+    _lagLastTime = status.time;
+    _sampleArrivalLag.add(offset - _lagBase, status.receivedTime);
+}
+
+// ---------------------------------------------------------------------------------------
+MplayerClient::MplayerClient(QObject* parent) : QObject(parent)
+{
+    qRegisterMetaType<QProcess::ProcessError>("QProcess::ProcessError");
+
+    _worker = new MplayerWorker;
+    _worker->moveToThread(&_thread);
+    _thread.start();
+    QMetaObject::invokeMethod(_worker, "init", Qt::BlockingQueuedConnection);
+
+    connect(_worker, SIGNAL(statusBatchReady()), this, SLOT(worker_statusBatchReady()));
+    connect(_worker, SIGNAL(finished()), this, SIGNAL(finished()));
+    connect(_worker, SIGNAL(eof()), this, SIGNAL(eof()));
+    connect(_worker, SIGNAL(queuedFileStarted()), this, SIGNAL(queuedFileStarted()));
+    connect(_worker, SIGNAL(error(QProcess::ProcessError)),
+            this,    SIGNAL(error(QProcess::ProcessError)));
+
+    MplayerOutputParser* parser = _worker->parser();
+    connect(parser, SIGNAL(messageLine(const QString&)),
+            this,   SIGNAL(messageLine(const QString&)));
+    connect(parser, SIGNAL(identifyInfo(int, const QString&)),
+            this,   SIGNAL(identifyInfo(int, const QString&)));
+    connect(parser, SIGNAL(cacheUnderrun()),
+            this,   SIGNAL(cacheUnderrun()));
+    connect(parser, SIGNAL(connecting()),
+            this,   SIGNAL(connecting()));
+    connect(parser, SIGNAL(cacheSizeSet()),
+            this,   SIGNAL(cacheSizeSet()));
+    connect(parser, SIGNAL(cacheFill(double)),
+            this,   SIGNAL(cacheFill(double)));
+    connect(parser, SIGNAL(generatingIndex(int)),
+            this,   SIGNAL(generatingIndex(int)));
+    connect(parser, SIGNAL(videoOutputReady(const QString&, const QSize&)),
+            this,   SIGNAL(videoOutputReady(const QString&, const QSize&)));
+    connect(parser, SIGNAL(paused()),
+            this,   SIGNAL(paused()));
+    connect(parser, SIGNAL(timePosAnswered(double)),
+            this,   SIGNAL(timePosAnswered(double)));
+    connect(parser, SIGNAL(eof()),
+            this,   SIGNAL(eof()));
+    connect(parser, SIGNAL(screenshotSaved(const QString&)),
+            this,   SIGNAL(screenshotSaved(const QString&)));
+    connect(parser, SIGNAL(screenshotFailed()),
+            this,   SIGNAL(screenshotFailed()));
+}
+
+MplayerClient::~MplayerClient()
+{
+    QMetaObject::invokeMethod(_worker, "cleanup", Qt::BlockingQueuedConnection);
+    _thread.quit();
+    _thread.wait();
+
+    delete _worker;
+}
+
+void MplayerClient::start(const QString& program, const QStringList& arguments)
+{
+    QMetaObject::invokeMethod(_worker, "start", Qt::BlockingQueuedConnection,
+                              Q_ARG(QString, program), Q_ARG(QStringList, arguments));
+
+    // 起動失敗時のerror()を呼び出し元へ戻る前に発行する
+    flushEvents();
+}
+
+// プロセスの終了を待たずに戻る
+void MplayerClient::terminate()
+{
+    QMetaObject::invokeMethod(_worker, "terminate", Qt::BlockingQueuedConnection);
+
+    // 切り離すまでの出力とfinished()を呼び出し元へ戻る前に発行する
+    flushEvents();
+}
+
+void MplayerClient::loadFile(const QString& path)
+{
+    QMetaObject::invokeMethod(_worker, "loadFile", Qt::QueuedConnection, Q_ARG(QString, path));
+}
+
+void MplayerClient::queueFile(const QString& path)
+{
+    QMetaObject::invokeMethod(_worker, "queueFile", Qt::QueuedConnection, Q_ARG(QString, path));
+}
+
+// -idleで起動したプロセスの場合は再生のみを停止する。finished()は戻る前に発行される
+void MplayerClient::stopFile()
+{
+    QMetaObject::invokeMethod(_worker, "stopFile", Qt::BlockingQueuedConnection);
+    flushEvents();
+}
+
+void MplayerClient::command(const QString& command)
+{
+    QMetaObject::invokeMethod(_worker, "command", Qt::QueuedConnection, Q_ARG(QString, command));
+}
+
+void MplayerClient::receiveMplayerChildProcess()
+{
+    QMetaObject::invokeMethod(_worker, "receiveMplayerChildProcess", Qt::QueuedConnection);
+}
+
+void MplayerClient::setPollInterval(int msec)
+{
+    QMetaObject::invokeMethod(_worker, "setPollInterval", Qt::QueuedConnection, Q_ARG(int, msec));
+}
+
+void MplayerClient::worker_statusBatchReady()
+{
+    MplayerStatusBatch batch;
+    if( _worker->takeStatusBatch(&batch) )
+        emit statusBatch(batch);
+}
+
+// ワーカースレッドから届いている未処理のシグナルを全て発行する
+void MplayerClient::flushEvents()
+{
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
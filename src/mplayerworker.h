@@ -0,0 +1,175 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MPLAYERWORKER_H
+#define MPLAYERWORKER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QList>
+#include <QProcess>
+#include <QStringList>
+#include <QSize>
+#include "mplayerstatus.h"
+#include "mplayercommandqueue.h"
+#include "startuptrace.h"
+#include "metrics.h"
+
+class QTimer;
+class MplayerProcess;
+class MplayerOutputParser;
+
+// GUIスレッドが受け取るまでの間に溜まったステータス行の集約結果
+struct MplayerStatusBatch
+{
+    MplayerStatus first;        // 最初のステータス
+    MplayerStatus last;         // 最新のステータス
+    int           count;        // 集約したステータス行数
+    int           frameCount;   // フレーム数が変化したステータス行数
+    QString       lastLine;     // 最新のステータス行(ログ出力用)
+};
+
+// ワーカースレッド側。mplayerプロセスの入出力と出力行の解析を行う
+class MplayerWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    MplayerWorker();
+
+    MplayerOutputParser*   parser()  { return _parser; }
+    QProcess::ProcessState state() const { return (QProcess::ProcessState)(int)_state; }
+    bool isIdle() const { return (int)_idleReady != 0; }
+    bool takeStatusBatch(MplayerStatusBatch* batch);
+
+public slots:
+    void init();
+    void cleanup();
+    void start(const QString& program, const QStringList& arguments);
+    void loadFile(const QString& path);
+    void queueFile(const QString& path);
+    void stopFile();
+    void terminate();
+    void command(const QString& command);
+    void receiveMplayerChildProcess();
+    void setPollInterval(int msec);
+
+signals:
+    void statusBatchReady();
+    void finished();
+    void eof();
+    void queuedFileStarted();
+    void error(QProcess::ProcessError error);
+
+private slots:
+    void process_stateChanged(QProcess::ProcessState state);
+    void process_finished();
+    void process_outputLine(const QString& line, qint64 receivedTime);
+    void parser_fileStarted();
+    void parser_fileEnded(int code);
+    void parser_statusTick(const MplayerStatus& status, const QString& line);
+    void parser_videoOutputReady();
+    void parser_identifyInfo(int info);
+    void closeStatusBatch();
+    void resetArrivalLag();
+    void pollStatus();
+    void flushCommands();
+
+private:
+    void resetFile();
+    void endFile();
+    void createProcess();
+    void measureArrivalLag(const MplayerStatus& status);
+
+    MplayerProcess*      _process;
+    MplayerOutputParser* _parser;
+    QTimer*              _timerPoll;
+    int                  _pollInterval;     // 0の場合はステータス行から再生状態を取得する
+    QAtomicInt           _state;
+
+    bool                 _idle;             // -idleで起動した
+    bool                 _fileOpen;         // プレーヤ側から見て再生中のファイルがある
+    bool                 _awaitFileStart;   // 次のファイルのID_FILENAME=を待っている
+    bool                 _queuedFile;       // 再生中のファイルの次のファイルを追加した
+    QAtomicInt           _idleReady;        // -idleで起動し、ファイルを再生していない
+
+    MplayerCommandQueue  _commandQueue;
+    bool                 _flushScheduled;
+
+    QMutex                    _mutex;
+    QList<MplayerStatusBatch> _batches;
+    bool                      _batchOpen;   // _batchesの末尾へ集約可能
+    uint                      _lastFrame;
+
+    bool                 _lagBaseValid;
+    double               _lagBase;          // 到着遅れの基準(ms)
+    double               _lagLastTime;
+    MetricsSampler       _sampleArrivalLag;
+
+    StartupTrace         _startupTrace;
+};
+
+// GUIスレッド側。ワーカースレッドを所有し、MplayerProcessと同様の操作を提供する。
+// 解析結果のシグナルはGUIスレッドで発行される。
+class MplayerClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    MplayerClient(QObject* parent);
+    ~MplayerClient();
+
+    void start(const QString& program, const QStringList& arguments);
+    void loadFile(const QString& path);
+    void queueFile(const QString& path);
+    void stopFile();
+    void terminate();
+    void command(const QString& command);
+    void receiveMplayerChildProcess();
+    void setPollInterval(int msec);
+    QProcess::ProcessState state() const { return _worker->state(); }
+    bool isIdle() const { return _worker->isIdle(); }
+
+signals:
+    void statusBatch(const MplayerStatusBatch& batch);
+    void messageLine(const QString& line);
+    void identifyInfo(int info, const QString& value);
+    void cacheUnderrun();
+    void connecting();
+    void cacheSizeSet();
+    void cacheFill(double percent);
+    void generatingIndex(int percent);
+    void videoOutputReady(const QString& videoDriver, const QSize& videoSize);
+    void paused();
+    void timePosAnswered(double time);
+    void eof();
+    void queuedFileStarted();       // 末尾に達し、queueFile()したファイルの再生へ移った
+    void screenshotSaved(const QString& file);
+    void screenshotFailed();
+    void finished();
+    void error(QProcess::ProcessError error);
+
+private slots:
+    void worker_statusBatchReady();
+
+private:
+    void flushEvents();
+
+    QThread        _thread;
+    MplayerWorker* _worker;
+};
+
+#endif // MPLAYERWORKER_H
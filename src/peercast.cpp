@@ -13,20 +13,19 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include <QUrl>
-#include <QNetworkRequest>
 #include <QNetworkReply>
-#include <QScriptEngine>
-#include <QXmlStreamReader>
 #include <QDebug>
 #include "peercast.h"
 #include "task.h"
 #include "logdialog.h"
+#include "jsonreader.h"
+#include "peercastclient.h"
+#include "metrics.h"
+
+QHash<QString, Peercast::TYPE> Peercast::s_typeCache;
 
 Peercast::Peercast(QObject* parent) : QObject(parent)
 {
-    connect(&_nam, SIGNAL(finished(QNetworkReply*)),
-            this, SLOT(nam_finished(QNetworkReply*)));
 
     _disconnectStartSec = 0;
 
@@ -56,12 +55,20 @@ void Peercast::stop()
 
 void Peercast::bump()
 {
-    QUrl url(QString("http://%1:%2/admin?cmd=bump&id=%3").arg(_host).arg(_port).arg(_id));
-    _nam.get(QNetworkRequest(url));
+    QNetworkReply* reply = PeercastClient::client(_host, _port)->get("/admin?cmd=bump&id=" + _id);
+    connect(reply, SIGNAL(finished()), this, SLOT(reply_finished()));
 }
 
+// 種類が判別済みであれば判別を省く。判別し直すのは取得に失敗した後のみ
 void Peercast::getChannelInfo()
 {
+    TYPE type = cachedType(_host, _port);
+    if( type != TYPE_UNKNOWN ) {
+        _type = type;
+        getChannelInfo_GetPeercastTypeTask_finished();
+        return;
+    }
+
     Task* task = new GetPeercastTypeTask(_host, _port, &_type, this);
     connect(task, SIGNAL(finished()),
             this, SLOT(getChannelInfo_GetPeercastTypeTask_finished()));
@@ -70,6 +77,10 @@ void Peercast::getChannelInfo()
 
 void Peercast::disconnectChannel(int startSec)
 {
+    TYPE type = cachedType(_host, _port);
+    if( type != TYPE_UNKNOWN )
+        _type = type;
+
     if( _type == TYPE_UNKNOWN ) {
         _disconnectStartSec = startSec;
         Task* task = new GetPeercastTypeTask(_host, _port, &_type, this);
@@ -81,6 +92,29 @@ void Peercast::disconnectChannel(int startSec)
         Task::push(new DisconnectChannelTask(_host, _port, _id, _type, startSec, this));
 }
 
+Peercast::TYPE Peercast::cachedType(const QString& host, ushort port)
+{
+    return s_typeCache.value(typeCacheKey(host, port), TYPE_UNKNOWN);
+}
+
+void Peercast::setCachedType(const QString& host, ushort port, TYPE type)
+{
+    if( type == TYPE_UNKNOWN )
+        forgetCachedType(host, port);
+    else
+        s_typeCache.insert(typeCacheKey(host, port), type);
+}
+
+void Peercast::forgetCachedType(const QString& host, ushort port)
+{
+    s_typeCache.remove(typeCacheKey(host, port));
+}
+
+QString Peercast::typeCacheKey(const QString& host, ushort port)
+{
+    return QString("%1:%2").arg(host).arg(port);
+}
+
 void Peercast::getChannelInfo_GetPeercastTypeTask_finished()
 {
     Task* task = new GetChannelInfoTask(_host, _port, _id, _type, this);
@@ -94,8 +128,9 @@ void Peercast::disconnectChannel_GetPeercastTypeTask_finished()
     Task::push(new DisconnectChannelTask(_host, _port, _id, _type, _disconnectStartSec, this));
 }
 
-void Peercast::nam_finished(QNetworkReply* reply)
+void Peercast::reply_finished()
 {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
     reply->deleteLater();
 }
 
@@ -176,82 +211,162 @@ ChannelInfo::STATUS ChannelInfo::statusFromString(const QString& status, Peercas
     return ret;
 }
 
+// ---------------------------------------------------------------------------------------
+void ViewXmlReader::clear(const QString& id)
+{
+    _xml.clear();
+    _id = id;
+    _state = STATE_READING;
+    _skipDepth = 0;
+    _rootFound = false;
+    _channel.clear();
+    _relay.clear();
+}
+
+ViewXmlReader::STATE ViewXmlReader::addData(const QByteArray& data)
+{
+    if( _state != STATE_READING )
+        return _state;
+
+    _xml.addData(data);
+    read();
+
+    return _state;
+}
+
+QString ViewXmlReader::errorString() const
+{
+    if( _state == STATE_NOT_FOUND )
+        return "relay element not found";
+
+    if( _xml.hasError() )
+        return _xml.errorString();
+
+    return "not a viewxml document";
+}
+
+// 最後まで読んで対象が無い場合、文書が正しく終わっていればSTATE_NOT_FOUNDとする
+ViewXmlReader::STATE ViewXmlReader::finish()
+{
+    if( _state == STATE_READING )
+        _state = (_rootFound && !_xml.hasError()) ? STATE_NOT_FOUND : STATE_ERROR;
+
+    return _state;
+}
+
+// 読める所まで読む。データが途中で切れている場合は次のaddData()で続きから読む
+void ViewXmlReader::read()
+{
+    while( !_xml.atEnd() ) {
+        _xml.readNext();
+
+        if( _xml.isStartElement() ) {
+            if( _skipDepth > 0 )
+                ++_skipDepth;
+            else
+            if( _xml.name() == "peercast" )
+                _rootFound = true;
+            else
+            if( _xml.name() == "channels_relayed" )
+                ;
+            else
+            if( _xml.name() == "channel" && _xml.attributes().value("id") == _id )
+                _channel = _xml.attributes();
+            else
+            if( _xml.name() == "relay" ) {
+                _relay = _xml.attributes();
+                _state = STATE_FOUND;
+                return;
+            }
+            else
+                _skipDepth = 1;
+        }
+        else
+        if( _xml.isEndElement() && _skipDepth > 0 )
+            --_skipDepth;
+    }
+
+    if( _xml.hasError() && _xml.error() != QXmlStreamReader::PrematureEndOfDocumentError )
+        _state = STATE_ERROR;
+}
+
 // ---------------------------------------------------------------------------------------
 GetPeercastTypeTask::GetPeercastTypeTask(const QString& host, ushort port,
         Peercast::TYPE* pType, QObject* parent) : Task(parent)
 {
+    _replyVp = NULL;
+    _replySt = NULL;
+
     _host = host;
     _port = port;
     _pType = pType;
-
-    connect(&_nam, SIGNAL(finished(QNetworkReply*)),
-            this,  SLOT(nam_finished(QNetworkReply*)));
-
-    _attemptTypes << Peercast::TYPE_VP << Peercast::TYPE_ST;
-    int i = _attemptTypes.indexOf(*_pType);
-    if( i > 0 )
-        _attemptTypes.move(i, 0);
 }
 
-void GetPeercastTypeTask::nam_finished(QNetworkReply* reply)
+// VPとSTの問い合わせを同時に送り、先に肯定の応答を返した方を採用する
+void GetPeercastTypeTask::reply_finished()
 {
-    bool failed = !(reply->error() == QNetworkReply::NoError);
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    bool found = false;
 
-    Q_ASSERT( !_attemptTypes.isEmpty() );
-//  LogDialog::debug(QString("peercast type %1").arg(_attemptTypes.first()));
-
-    if( !failed ) {
-        QString out = reply->readAll();
-        if( _attemptTypes.first() == Peercast::TYPE_ST )
-            failed = !whetherPcSt(out);
+    if( reply->error() == QNetworkReply::NoError ) {
+        QByteArray out = reply->readAll();
+        if( reply == _replySt )
+            found = whetherPcSt(out);
         else
-            failed = !whetherPcVp(out);
+            found = whetherPcVp(out);
+    }
 
-        if( !failed )
-            *_pType = _attemptTypes.first();
+    if( found ) {
+        *_pType = (reply == _replySt) ? Peercast::TYPE_ST : Peercast::TYPE_VP;
+        Peercast::setCachedType(_host, _port, *_pType);
     }
 
-    if( failed ) {
-        _attemptTypes.pop_front();
-        if( _attemptTypes.isEmpty() )
-            *_pType = Peercast::TYPE_UNKNOWN;
-        else {
-            queryPeercastType();
-            reply->deleteLater();
+    if( reply == _replyVp ) _replyVp = NULL;
+    if( reply == _replySt ) _replySt = NULL;
+    reply->deleteLater();
+
+    if( !found ) {
+        if( _replyVp != NULL || _replySt != NULL )  // 残りの応答を待つ
             return;
-        }
+
+        *_pType = Peercast::TYPE_UNKNOWN;
     }
 
-//  LogDialog::debug(QString("GetPeercastTypeTask::nam_finished(): peercast type %1").arg(*_pType));
+//  LogDialog::debug(QString("GetPeercastTypeTask::reply_finished(): peercast type %1").arg(*_pType));
 
-    reply->deleteLater();
+    abortReplies();
     deleteLater();
 }
 
 void GetPeercastTypeTask::start()
 {
-    queryPeercastType();
+    PeercastClient* client = PeercastClient::client(_host, _port);
+
+    _replyVp = client->get("/html/ja/index.html");
+    connect(_replyVp, SIGNAL(finished()), this, SLOT(reply_finished()));
+
+    _replySt = client->postJsonRpc(PeercastClient::jsonRpcRequest("getVersionInfo"));
+    connect(_replySt, SIGNAL(finished()), this, SLOT(reply_finished()));
+
+    Metrics::count("peercast.type.detections");
 }
 
-void GetPeercastTypeTask::queryPeercastType()
+// 不要になった問い合わせを中止する。中止によるfinished()は受け取らない
+void GetPeercastTypeTask::abortReplies()
 {
-    if( _attemptTypes.isEmpty() ) return;
+    QList<QNetworkReply*> replies;
+    replies << _replyVp << _replySt;
 
-    if( _attemptTypes.first() == Peercast::TYPE_VP ) {
-        QUrl url(QString("http://%1:%2/html/ja/index.html").arg(_host).arg(_port));
-        _nam.get(QNetworkRequest(url));
-    }
-    else {
-        QUrl url(QString("http://%1:%2/api/1").arg(_host).arg(_port));
-        QString json("{\"jsonrpc\": \"2.0\", \"method\": \"%1\", \"id\": 1}");
-        QNetworkRequest request(url);
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-        request.setRawHeader("X-Requested-With", "XMLHttpRequest");
-
-        QByteArray data(json.arg("getVersionInfo").toLatin1());
-        request.setHeader(QNetworkRequest::ContentLengthHeader, data.size());
-        _nam.post(request, data);
+    foreach(QNetworkReply* reply, replies) {
+        if( reply == NULL ) continue;
+
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
     }
+
+    _replyVp = NULL;
+    _replySt = NULL;
 }
 
 bool GetPeercastTypeTask::whetherPcVp(const QString& reply)
@@ -262,77 +377,58 @@ bool GetPeercastTypeTask::whetherPcVp(const QString& reply)
         return false;
 }
 
-bool GetPeercastTypeTask::whetherPcSt(const QString& reply)
+bool GetPeercastTypeTask::whetherPcSt(const QByteArray& reply)
 {
-    QScriptEngine engine;
-    QScriptValue  value;
-    value = engine.evaluate("JSON.parse").call(QScriptValue(), QScriptValueList() << reply);
-
-    if( value.isError() )
-        return false;
-
-    value = value.property("result");
-    if( !value.isValid() )
-        return false;
-
-    return true;
+    return JsonReader(reply).contains("result");
 }
 
 // ---------------------------------------------------------------------------------------
 GetChannelInfoTask::GetChannelInfoTask(const QString& host, ushort port, const QString& id,
     Peercast::TYPE type, QObject* parent) : Task(parent)
 {
-    connect(&_nam, SIGNAL(finished(QNetworkReply*)),
-            this,  SLOT(nam_finished(QNetworkReply*)));
-
-    _replyChannelInfo       = NULL;
-    _replyChannelStatusPcSt = NULL;
-
     _host = host;
     _port = port;
     _id   = id;
     _type = type;
+    _unexpectedReply = false;
 }
 
-void GetChannelInfoTask::nam_finished(QNetworkReply* reply)
+void GetChannelInfoTask::reply_finished()
 {
-    const QString debugPrefix = "GetChannelInfoTask::nam_finished(): ";
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    const QString debugPrefix = "GetChannelInfoTask::reply_finished(): ";
+    bool succeeded = false;
+    bool forgetType = false;
 
-        // PeercastIMではviewxml返却時のヘッダに誤りがある為、その場合のエラーは通過させる
+        // PeercastIMではviewxml返却時のヘッダに誤りがある為、その場合のエラーは通過させる。
+        // reply_readyRead()で中止した場合も、必要な要素は読み終えている
     if( reply->error() == QNetworkReply::NoError
-     || (reply->error()==QNetworkReply::RemoteHostClosedError && _type!=Peercast::TYPE_ST) )
+     || (reply->error()==QNetworkReply::RemoteHostClosedError && _type!=Peercast::TYPE_ST)
+     || _viewXml.state() == ViewXmlReader::STATE_FOUND )
     {
-        QString out = reply->readAll();
-
-        if( reply == _replyChannelInfo ) {
-            _replyChannelInfo = NULL;
-
-            if( _type == Peercast::TYPE_ST ) {
-                if( parseChannelInfoPcSt(out) ) {
-                    getChannelStatusPcSt();
-                    reply->deleteLater();
-                    return;
-                }
-            }
-            else { // _type==Peercast::TYPE_VP || _type==Peercast::TYPE_UNKNOWN
-                if( parseChannelInfoPcVp(out) ) {
-//                  LogDialog::debug(_chInfo.toString(debugPrefix));
-                    emit finished(_chInfo);
-                }
-            }
+        if( _type == Peercast::TYPE_ST )
+            succeeded = parseChannelInfoStatusPcSt(reply->readAll());
+        else { // _type==Peercast::TYPE_VP || _type==Peercast::TYPE_UNKNOWN
+            _viewXml.addData(reply->readAll());
+            succeeded = parseChannelInfoPcVp();
         }
-        else
-        if( reply == _replyChannelStatusPcSt ) {
-            _replyChannelStatusPcSt = NULL;
 
-            if( parseChannelStatusPcSt(out) ) {
-//              LogDialog::debug(_chInfo.toString(debugPrefix));
-                emit finished(_chInfo);
-            }
-        }
+        forgetType = !succeeded && _unexpectedReply;
     }
-    else
+    else {
         LogDialog::debug(debugPrefix + "reply error " + QString::number(reply->error()), QColor(255,0,0));
+        forgetType = true;
+    }
+
+    if( succeeded ) {
+//      LogDialog::debug(_chInfo.toString(debugPrefix));
+        emit finished(_chInfo);
+    }
+
+    // 通信エラー、又は応答の形式が違う場合は、次回の取得時に種類を判別し直す。
+    // チャンネルが無いだけの場合は判別し直さない
+    if( forgetType )
+        Peercast::forgetCachedType(_host, _port);
 
     reply->deleteLater();
     deleteLater();
@@ -345,146 +441,127 @@ void GetChannelInfoTask::start()
 //      return;
 //  }
 
+    PeercastClient* client = PeercastClient::client(_host, _port);
+    QNetworkReply* reply;
+
     if( _type == Peercast::TYPE_ST ) {
-        QUrl url(QString("http://%1:%2/api/1").arg(_host).arg(_port));
-        QString json("{\"jsonrpc\": \"2.0\", \"method\": \"%1\", \"params\": [\"" + _id + "\"], \"id\": 1}");
-        QNetworkRequest request(url);
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-        request.setRawHeader("X-Requested-With", "XMLHttpRequest");
-
-        QByteArray data(json.arg("getChannelInfo").toLatin1());
-        request.setHeader(QNetworkRequest::ContentLengthHeader, data.size());
-        _replyChannelInfo = _nam.post(request, data);
+        // チャンネル情報と状態をバッチで1回の往復で取得する
+        QList<QByteArray> requests;
+        requests << PeercastClient::jsonRpcRequest("getChannelInfo", _id, RPC_ID_CHANNEL_INFO)
+                 << PeercastClient::jsonRpcRequest("getChannelStatus", _id, RPC_ID_CHANNEL_STATUS);
+
+        reply = client->postJsonRpc(PeercastClient::jsonRpcBatch(requests));
     }
     else { // _type==Peercast::TYPE_VP || _type==Peercast::TYPE_UNKNOWN
-        QUrl url(QString("http://%1:%2/admin?cmd=viewxml").arg(_host).arg(_port));
-        _replyChannelInfo = _nam.get(QNetworkRequest(url));
+        _viewXml.clear(_id);
+        reply = client->get("/admin?cmd=viewxml", PeercastClient::DEFAULT_TIMEOUT, false);
+        connect(reply, SIGNAL(readyRead()), this, SLOT(reply_readyRead()));
     }
+
+    connect(reply, SIGNAL(finished()), this, SLOT(reply_finished()));
 }
 
-void GetChannelInfoTask::getChannelStatusPcSt()
+// 対象のrelay要素を読んだ時点で残りの受信を中止する。中止によりreply_finished()が呼ばれる。
+// 中止すると接続は切れるが、viewxmlはパイプライン化していない為、他の要求には影響しない
+void GetChannelInfoTask::reply_readyRead()
 {
-    if( _type == Peercast::TYPE_ST ) {
-        QUrl url(QString("http://%1:%2/api/1").arg(_host).arg(_port));
-        QString json("{\"jsonrpc\": \"2.0\", \"method\": \"%1\", \"params\": [\"" + _id + "\"], \"id\": 1}");
-        QNetworkRequest request(url);
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-        request.setRawHeader("X-Requested-With", "XMLHttpRequest");
-
-        QByteArray data(json.arg("getChannelStatus").toLatin1());
-        request.setHeader(QNetworkRequest::ContentLengthHeader, data.size());
-        _replyChannelStatusPcSt = _nam.post(request, data);
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+
+    if( _viewXml.addData(reply->readAll()) == ViewXmlReader::STATE_FOUND ) {
+        Metrics::count("peercast.viewxml.early_exits");
+        reply->disconnect(this, SLOT(reply_readyRead()));
+        reply->abort();
     }
 }
 
-bool GetChannelInfoTask::parseChannelInfoPcVp(const QString& reply)
+bool GetChannelInfoTask::parseChannelInfoPcVp()
 {
     const QString debugPrefix = "GetChannelInfoTask::parseChannelInfoPcVp(): ";
 //  LogDialog::debug(debugPrefix + "called");
 
-    QXmlStreamReader xml(reply);
-    QString status;
+    ViewXmlReader::STATE state = _viewXml.finish();
+    if( state != ViewXmlReader::STATE_FOUND ) {
+        LogDialog::debug(debugPrefix + _viewXml.errorString());
+        _unexpectedReply = state == ViewXmlReader::STATE_ERROR;
+        return false;
+    }
 
-    while( !xml.atEnd() ) {
-        xml.readNext();
-//      LogDialog::debug(QString("%1/%2").arg(xml.isStartElement()).arg(xml.name().toString()));
+    const QXmlStreamAttributes& channel = _viewXml.channel();
+    _chInfo.chName = channel.value("name").toString();
+    _chInfo.contactUrl = channel.value("url").toString();
+    _chInfo.bitrate = channel.value("bitrate").toString().toInt();
 
-        if( xml.isStartElement() ) {
-            if( xml.name() == "peercast" )
-                ;
-            else
-            if( xml.name() == "channels_relayed" )
-                ;
-            else
-            if( xml.name() == "channel" && xml.attributes().value("id") == _id ) {
-                _chInfo.chName = xml.attributes().value("name").toString();
-                _chInfo.contactUrl = xml.attributes().value("url").toString();
-                _chInfo.bitrate = xml.attributes().value("bitrate").toString().toInt();
-
-                // 不要
-//              QTextDocument txt;
-//              txt.setHtml(_chInfo.chName);
-//              _chInfo.chName = txt.toPlainText();
-            }
-            else
-            if( xml.name() == "relay" ) {
-                _chInfo.localRelays = xml.attributes().value("relays").toString().toInt();
-                _chInfo.totalRelays = xml.attributes().value("hosts").toString().toInt();
+    // 不要
+//  QTextDocument txt;
+//  txt.setHtml(_chInfo.chName);
+//  _chInfo.chName = txt.toPlainText();
 
-                status = xml.attributes().value("status").toString();
-                _chInfo.status = ChannelInfo::statusFromString(status, Peercast::TYPE_VP);
-                break;
-            }
-            else
-                xml.skipCurrentElement();
-        }
-    }
+    const QXmlStreamAttributes& relay = _viewXml.relay();
+    _chInfo.localRelays = relay.value("relays").toString().toInt();
+    _chInfo.totalRelays = relay.value("hosts").toString().toInt();
 
-    if( xml.hasError() ) {
-        LogDialog::debug(debugPrefix + xml.errorString());
-        return false;
-    }
+    QString status = relay.value("status").toString();
+    _chInfo.status = ChannelInfo::statusFromString(status, Peercast::TYPE_VP);
 
+    _unexpectedReply = status.isNull();
     return !status.isNull();
 }
 
-bool GetChannelInfoTask::parseChannelInfoPcSt(const QString& reply)
+bool GetChannelInfoTask::parseChannelInfoStatusPcSt(const QByteArray& reply)
 {
-    const QString debugPrefix = "GetChannelInfoTask::parseChannelInfoPcSt(): ";
+    const QString debugPrefix = "GetChannelInfoTask::parseChannelInfoStatusPcSt(): ";
 //  LogDialog::debug(debugPrefix + "called");
 
-    QScriptEngine engine;
-    QScriptValue  value;
-//  value = engine.evaluate("(" + reply + ")");
-    value = engine.evaluate("JSON.parse").call(QScriptValue(), QScriptValueList() << reply);
+    JsonReader json(reply);
+    _unexpectedReply = true;
+
+    if( !json.isValid() ) {
+        LogDialog::debug(debugPrefix + "invalid json", QColor(255,0,0));
+        return false;
+    }
 
-    if( value.isError() ) {
-        LogDialog::debug(debugPrefix + value.toString(), QColor(255,0,0));
+    // チャンネルが無い場合はerrorが返る
+    QString info   = PeercastClient::jsonRpcResultPath(json, RPC_ID_CHANNEL_INFO);
+    QString status = PeercastClient::jsonRpcResultPath(json, RPC_ID_CHANNEL_STATUS);
+    if( info.isEmpty() || status.isEmpty() ) {
+        _unexpectedReply = (info.isEmpty()
+                            && PeercastClient::jsonRpcErrorPath(json, RPC_ID_CHANNEL_INFO).isEmpty())
+                        || (status.isEmpty()
+                            && PeercastClient::jsonRpcErrorPath(json, RPC_ID_CHANNEL_STATUS).isEmpty());
         return false;
     }
 
-    value = value.property("result").property("info");
-    if( !value.isValid() )
+    if( !json.contains(info + ".info") )
         return false;
 
-    _chInfo.chName     = value.property("name").toString();
-    _chInfo.contactUrl = value.property("url").toString();
-    _chInfo.bitrate    = value.property("bitrate").toInt32();
+    _unexpectedReply = false;
+
+    parseChannelInfoPcSt(json, info);
+    parseChannelStatusPcSt(json, status);
 
     return true;
 }
 
-bool GetChannelInfoTask::parseChannelStatusPcSt(const QString& reply)
+// resultは応答中のresultのパス
+void GetChannelInfoTask::parseChannelInfoPcSt(const JsonReader& json, const QString& result)
 {
-    const QString debugPrefix = "GetChannelInfoTask::parseChannelStatusPcSt(): ";
-//  LogDialog::debug(debugPrefix + "called");
-
-    QScriptEngine engine;
-    QScriptValue  value;
-//  value = engine.evaluate("(" + reply + ")");
-    value = engine.evaluate("JSON.parse").call(QScriptValue(), QScriptValueList() << reply);
-
-    if( value.isError() ) {
-        LogDialog::debug(debugPrefix + value.toString(), QColor(255,0,0));
-        return false;
-    }
-
-    value = value.property("result");
-    if( !value.isValid() )
-        return false;
+    _chInfo.chName     = json.toString(result + ".info.name");
+    _chInfo.contactUrl = json.toString(result + ".info.url");
+    _chInfo.bitrate    = json.toInt(result + ".info.bitrate");
+}
 
-    _chInfo.localRelays = value.property("localRelays").toString().toInt();
-    _chInfo.totalRelays = value.property("totalRelays").toString().toInt();
+void GetChannelInfoTask::parseChannelStatusPcSt(const JsonReader& json, const QString& result)
+{
+    _chInfo.localRelays = json.toInt(result + ".localRelays");
+    _chInfo.totalRelays = json.toInt(result + ".totalRelays");
 
-    if( value.property("isBroadcasting").toBool() ) {
+    if( json.toBool(result + ".isBroadcasting") ) {
         _chInfo.status = ChannelInfo::ST_BROADCAST;
     }
     else {
-        QString status = value.property("status").toString();
+        QString status = json.toString(result + ".status");
         _chInfo.status = ChannelInfo::statusFromString(status, Peercast::TYPE_ST);
     }
-
-    return true;
 }
 
 // ---------------------------------------------------------------------------------------
@@ -495,20 +572,19 @@ StopChannelTask::StopChannelTask(const QString& host, ushort port, const QString
     _port = port;
     _id   = id;
 
-    connect(&_nam, SIGNAL(finished(QNetworkReply*)),
-            this,  SLOT(nam_finished(QNetworkReply*)));
 }
 
-void StopChannelTask::nam_finished(QNetworkReply* reply)
+void StopChannelTask::reply_finished()
 {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
     reply->deleteLater();
     deleteLater();
 }
 
 void StopChannelTask::start()
 {
-    QUrl url(QString("http://%1:%2/admin?cmd=stop&id=%3").arg(_host).arg(_port).arg(_id));
-    _nam.get(QNetworkRequest(url));
+    QNetworkReply* reply = PeercastClient::client(_host, _port)->get("/admin?cmd=stop&id=" + _id);
+    connect(reply, SIGNAL(finished()), this, SLOT(reply_finished()));
 }
 
 // ---------------------------------------------------------------------------------------
@@ -523,46 +599,62 @@ DisconnectChannelTask::DisconnectChannelTask(const QString& host, ushort port,
     _startSec = startSec;
     _localListeners = -1;
     _status = ChannelInfo::ST_UNKNOWN;
-
-    connect(&_nam, SIGNAL(finished(QNetworkReply*)),
-            this,  SLOT(nam_finished(QNetworkReply*)));
+    _unexpectedReply = false;
 }
 
 void DisconnectChannelTask::timerSingleShot_timeout()
 {
-    if( _type == Peercast::TYPE_ST ) {
-        QUrl url(QString("http://%1:%2/api/1").arg(_host).arg(_port));
-        QString json("{\"jsonrpc\": \"2.0\", \"method\": \"%1\", \"params\": [\"" + _id + "\"], \"id\": 1}");
-        QNetworkRequest request(url);
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-        request.setRawHeader("X-Requested-With", "XMLHttpRequest");
-
-        QByteArray data(json.arg("getChannelStatus").toLatin1());
-        request.setHeader(QNetworkRequest::ContentLengthHeader, data.size());
-        _nam.post(request, data);
-    }
+    PeercastClient* client = PeercastClient::client(_host, _port);
+    QNetworkReply* reply;
+
+    if( _type == Peercast::TYPE_ST )
+        reply = client->postJsonRpc(PeercastClient::jsonRpcRequest("getChannelStatus", _id));
     else { // _type==Peercast::TYPE_VP || _type==Peercast::TYPE_UNKNOWN
-        QUrl url(QString("http://%1:%2/admin?cmd=viewxml").arg(_host).arg(_port));
-        _nam.get(QNetworkRequest(url));
+        _viewXml.clear(_id);
+        reply = client->get("/admin?cmd=viewxml", PeercastClient::DEFAULT_TIMEOUT, false);
+        connect(reply, SIGNAL(readyRead()), this, SLOT(reply_readyRead()));
+    }
+
+    connect(reply, SIGNAL(finished()), this, SLOT(reply_finished()));
+}
+
+// 対象のrelay要素を読んだ時点で残りの受信を中止する。中止によりreply_finished()が呼ばれる。
+// 中止すると接続は切れるが、viewxmlはパイプライン化していない為、他の要求には影響しない
+void DisconnectChannelTask::reply_readyRead()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+
+    if( _viewXml.addData(reply->readAll()) == ViewXmlReader::STATE_FOUND ) {
+        Metrics::count("peercast.viewxml.early_exits");
+        reply->disconnect(this, SLOT(reply_readyRead()));
+        reply->abort();
     }
 }
 
-void DisconnectChannelTask::nam_finished(QNetworkReply* reply)
+void DisconnectChannelTask::reply_finished()
 {
-        // PeercastIMではviewxml返却時のヘッダに誤りがある為、その場合のエラーは通過させる
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+        // PeercastIMではviewxml返却時のヘッダに誤りがある為、その場合のエラーは通過させる。
+        // reply_readyRead()で中止した場合も、必要な要素は読み終えている
     if( reply->error() == QNetworkReply::NoError
-     || (reply->error()==QNetworkReply::RemoteHostClosedError && _type!=Peercast::TYPE_ST) )
+     || (reply->error()==QNetworkReply::RemoteHostClosedError && _type!=Peercast::TYPE_ST)
+     || _viewXml.state() == ViewXmlReader::STATE_FOUND )
     {
-        QString out = reply->readAll();
-
         bool result = false;
         if( _type == Peercast::TYPE_ST )
-            result = getChannelStatusPcSt(out);
-        else
-            result = getChannelStatusPcVp(out);
+            result = getChannelStatusPcSt(reply->readAll());
+        else {
+            _viewXml.addData(reply->readAll());
+            result = getChannelStatusPcVp();
+        }
 
-        qDebug("DisconnectChannelTask::nam_finished(): result: %d, localListeners: %d, status: %s",
+        qDebug("DisconnectChannelTask::reply_finished(): result: %d, localListeners: %d, status: %s",
                result, _localListeners, ChannelInfo::statusString(_status).toAscii().constData());
+        // 応答の形式が違う場合は、次回の取得時に種類を判別し直す。
+        // チャンネルが無いだけの場合は判別し直さない
+        if( !result && _unexpectedReply )
+            Peercast::forgetCachedType(_host, _port);
+
         if( result ) {
             if( _status != ChannelInfo::ST_BROADCAST ) {
                 if( _localListeners == 0 ) {
@@ -584,7 +676,8 @@ void DisconnectChannelTask::nam_finished(QNetworkReply* reply)
         }
     }
     else {
-        qDebug("DisconnectChannelTask::nam_finished(): reply error");
+        qDebug("DisconnectChannelTask::reply_finished(): reply error");
+        Peercast::forgetCachedType(_host, _port);
     }
 
     reply->deleteLater();
@@ -598,64 +691,44 @@ void DisconnectChannelTask::start()
     qDebug("DisconnectChannelTask::start(): peercast type %d", _type);
 }
 
-bool DisconnectChannelTask::getChannelStatusPcVp(const QString& reply)
+bool DisconnectChannelTask::getChannelStatusPcVp()
 {
-    QXmlStreamReader xml(reply);
     _localListeners = -1;
 
-    while( !xml.atEnd() ) {
-        xml.readNext();
-//      qDebug() << QString("%1/%2").arg(xml.isStartElement()).arg(xml.name().toString());
-
-        if( xml.isStartElement() ) {
-            if( xml.name() == "peercast" )
-                ;
-            else
-            if( xml.name() == "channels_relayed" )
-                ;
-            else
-            if( xml.name() == "channel" && xml.attributes().value("id") == _id )
-                ;
-            else
-            if( xml.name() == "relay" ) {
-                _localListeners = xml.attributes().value("listeners").toString().toInt();
-                QString status = xml.attributes().value("status").toString();
-                _status = ChannelInfo::statusFromString(status, Peercast::TYPE_VP);
-                break;
-            }
-            else
-                xml.skipCurrentElement();
-        }
-    }
-
-    if( xml.hasError() ) {
-        qDebug() << "DisconnectChannelTask::getChannelStatusPcVp():" << xml.errorString();
+    ViewXmlReader::STATE state = _viewXml.finish();
+    if( state != ViewXmlReader::STATE_FOUND ) {
+        qDebug() << "DisconnectChannelTask::getChannelStatusPcVp():" << _viewXml.errorString();
+        _unexpectedReply = state == ViewXmlReader::STATE_ERROR;
         return false;
     }
 
-    return _localListeners != -1;
+    const QXmlStreamAttributes& relay = _viewXml.relay();
+    _localListeners = relay.value("listeners").toString().toInt();
+    QString status = relay.value("status").toString();
+    _status = ChannelInfo::statusFromString(status, Peercast::TYPE_VP);
+
+    return true;
 }
 
-bool DisconnectChannelTask::getChannelStatusPcSt(const QString& reply)
+bool DisconnectChannelTask::getChannelStatusPcSt(const QByteArray& reply)
 {
-    QScriptEngine engine;
-    QScriptValue  value;
-    value = engine.evaluate("JSON.parse").call(QScriptValue(), QScriptValueList() << reply);
+    JsonReader json(reply);
 
-    if( value.isError() )
-        return false;
-
-    value = value.property("result");
-    if( !value.isValid() )
+    // バッチで他の要求とまとめて送った場合の応答も受け付ける。
+    // チャンネルが無い場合はerrorが返る
+    QString result = PeercastClient::jsonRpcResultPath(json);
+    if( result.isEmpty() ) {
+        _unexpectedReply = PeercastClient::jsonRpcErrorPath(json).isEmpty();
         return false;
+    }
 
-    _localListeners = value.property("localDirects").toString().toInt();
+    _localListeners = json.toInt(result + ".localDirects");
 
-    if( value.property("isBroadcasting").toBool() ) {
+    if( json.toBool(result + ".isBroadcasting") ) {
         _status = ChannelInfo::ST_BROADCAST;
     }
     else {
-        QString status = value.property("status").toString();
+        QString status = json.toString(result + ".status");
         _status = ChannelInfo::statusFromString(status, Peercast::TYPE_ST);
     }
 
@@ -17,9 +17,12 @@
 #define PEERCAST_H
 
 #include <QTimer>
-#include <QNetworkAccessManager>
+#include <QHash>
+#include <QXmlStreamReader>
 #include "task.h"
 
+class QNetworkReply;
+class JsonReader;
 class ChannelInfo;
 
 class Peercast : public QObject
@@ -40,16 +43,23 @@ public:
     void getChannelInfo();
     void disconnectChannel(int startSec);
 
+    static TYPE cachedType(const QString& host, ushort port);
+    static void setCachedType(const QString& host, ushort port, TYPE type);
+    static void forgetCachedType(const QString& host, ushort port);
+
 signals:
     void gotChannelInfo(const ChannelInfo&);
 
 protected slots:
     void getChannelInfo_GetPeercastTypeTask_finished();
     void disconnectChannel_GetPeercastTypeTask_finished();
-    void nam_finished(QNetworkReply*);
+    void reply_finished();
 
 private:
-    QNetworkAccessManager _nam;
+    static QString typeCacheKey(const QString& host, ushort port);
+
+    static QHash<QString, TYPE> s_typeCache;    // 判別済みのhost:port毎のPeerCastの種類
+
     int _disconnectStartSec;
 
     QString _host;
@@ -94,6 +104,36 @@ public:
     static STATUS statusFromString(const QString& status, Peercast::TYPE type);
 };
 
+// PeerCast VPの/admin?cmd=viewxmlを受信しながら読み、指定したチャンネルのrelay要素を探す。
+// 対象以外の要素は読み飛ばし、relay要素を読んだ時点で以降のデータは不要になる
+class ViewXmlReader
+{
+public:
+    // STATE_NOT_FOUNDは文書は正しいが対象のチャンネルが無い場合
+    enum STATE { STATE_READING, STATE_FOUND, STATE_NOT_FOUND, STATE_ERROR };
+
+    ViewXmlReader() { clear(QString()); }
+    void  clear(const QString& id);
+    STATE addData(const QByteArray& data);
+    STATE finish();     // データの終端
+    STATE state() const { return _state; }
+    QString errorString() const;
+
+    const QXmlStreamAttributes& channel() const { return _channel; }
+    const QXmlStreamAttributes& relay()   const { return _relay; }
+
+private:
+    void read();
+
+    QXmlStreamReader     _xml;
+    QString              _id;
+    STATE                _state;
+    int                  _skipDepth;    // 読み飛ばし中の要素の深さ
+    bool                 _rootFound;    // peercast要素を読んだか
+    QXmlStreamAttributes _channel;
+    QXmlStreamAttributes _relay;
+};
+
 class GetPeercastTypeTask : public Task
 {
     Q_OBJECT
@@ -102,17 +142,17 @@ public:
     GetPeercastTypeTask(const QString& host, ushort port, Peercast::TYPE* pType, QObject* parent);
 
 protected slots:
-    void nam_finished(QNetworkReply*);
+    void reply_finished();
 
 protected:
     void start();
-    void queryPeercastType();
+    void abortReplies();
     bool whetherPcVp(const QString& reply);
-    bool whetherPcSt(const QString& reply);
+    bool whetherPcSt(const QByteArray& reply);
 
 private:
-    QNetworkAccessManager _nam;
-    QList<Peercast::TYPE> _attemptTypes;
+    QNetworkReply* _replyVp;
+    QNetworkReply* _replySt;
 
     QString _host;
     ushort  _port;
@@ -131,25 +171,26 @@ signals:
     void finished(const ChannelInfo&);
 
 protected slots:
-    void nam_finished(QNetworkReply*);
+    void reply_readyRead();
+    void reply_finished();
 
 protected:
     void start();
-    void getChannelStatusPcSt();
-    bool parseChannelInfoPcVp(const QString& reply);
-    bool parseChannelInfoPcSt(const QString& reply);
-    bool parseChannelStatusPcSt(const QString& reply);
+    bool parseChannelInfoPcVp();
+    bool parseChannelInfoStatusPcSt(const QByteArray& reply);
+    void parseChannelInfoPcSt(const JsonReader& json, const QString& result);
+    void parseChannelStatusPcSt(const JsonReader& json, const QString& result);
 
 private:
-    QNetworkAccessManager _nam;
-    QNetworkReply* _replyChannelInfo;
-    QNetworkReply* _replyChannelStatusPcSt;
+    enum { RPC_ID_CHANNEL_INFO = 1, RPC_ID_CHANNEL_STATUS };
 
     QString _host;
     ushort  _port;
     QString _id;
     Peercast::TYPE _type;
     ChannelInfo _chInfo;
+    ViewXmlReader _viewXml;
+    bool    _unexpectedReply;   // 応答の形式が_typeのものと異なる
 };
 
 class StopChannelTask : public Task
@@ -160,13 +201,12 @@ public:
     StopChannelTask(const QString& host, ushort port, const QString& id, QObject* parent);
 
 protected slots:
-    void nam_finished(QNetworkReply*);
+    void reply_finished();
 
 protected:
     void start();
 
 private:
-    QNetworkAccessManager _nam;
     QString _host;
     ushort  _port;
     QString _id;
@@ -182,17 +222,17 @@ public:
 
 protected slots:
     void timerSingleShot_timeout();
-    void nam_finished(QNetworkReply*);
+    void reply_readyRead();
+    void reply_finished();
 
 protected:
     void start();
-    bool getChannelStatusPcVp(const QString& reply);
-    bool getChannelStatusPcSt(const QString& reply);
+    bool getChannelStatusPcVp();
+    bool getChannelStatusPcSt(const QByteArray& reply);
 
 private:
     enum { REPETITION_MSEC = 5000 };
 
-    QNetworkAccessManager _nam;
     QString _host;
     ushort  _port;
     QString _id;
@@ -200,6 +240,8 @@ private:
     int     _startSec;
     int     _localListeners;
     ChannelInfo::STATUS _status;
+    ViewXmlReader _viewXml;
+    bool    _unexpectedReply;   // 応答の形式が_typeのものと異なる
 };
 
 #endif // PEERCAST_H
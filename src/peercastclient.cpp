@@ -0,0 +1,148 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QUrl>
+#include "peercastclient.h"
+#include "jsonreader.h"
+#include "metrics.h"
+
+QNetworkAccessManager*          PeercastClient::s_nam = NULL;
+QHash<QString, PeercastClient*> PeercastClient::s_clients;
+
+// GUIスレッドから呼ぶ
+PeercastClient* PeercastClient::client(const QString& host, ushort port)
+{
+    if( s_nam == NULL )
+        s_nam = new QNetworkAccessManager(qApp);
+
+    QString key = QString("%1:%2").arg(host).arg(port);
+
+    PeercastClient* client = s_clients.value(key);
+    if( client == NULL ) {
+        client = new PeercastClient(host, port, qApp);
+        s_clients.insert(key, client);
+    }
+
+    return client;
+}
+
+PeercastClient::PeercastClient(const QString& host, ushort port, QObject* parent)
+    : QObject(parent)
+{
+    _baseUrl = QString("http://%1:%2").arg(host).arg(port);
+}
+
+// GETは同じ接続へ続けて送れる様にパイプライン化を許可する。
+// 途中でabort()する要求はpipeliningをfalseにし、後続の要求を巻き込まない様にする
+QNetworkReply* PeercastClient::get(const QString& pathAndQuery, int timeoutMsec, bool pipelining)
+{
+    QNetworkRequest request(QUrl(_baseUrl + pathAndQuery));
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, pipelining);
+
+    Metrics::count("peercast.http.requests");
+    return startTimeout(s_nam->get(request), timeoutMsec);
+}
+
+QNetworkReply* PeercastClient::postJsonRpc(const QByteArray& json, int timeoutMsec)
+{
+    QNetworkRequest request(QUrl(_baseUrl + "/api/1"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setHeader(QNetworkRequest::ContentLengthHeader, json.size());
+    request.setRawHeader("X-Requested-With", "XMLHttpRequest");
+
+    Metrics::count("peercast.http.requests");
+    return startTimeout(s_nam->post(request, json), timeoutMsec);
+}
+
+// idが空の場合はparamsを付けない
+QByteArray PeercastClient::jsonRpcRequest(const QString& method, const QString& id, int requestId)
+{
+    QString json;
+    if( id.isEmpty() )
+        json = QString("{\"jsonrpc\": \"2.0\", \"method\": \"%1\", \"id\": %2}")
+                    .arg(method).arg(requestId);
+    else
+        json = QString("{\"jsonrpc\": \"2.0\", \"method\": \"%1\", \"params\": [\"%2\"], \"id\": %3}")
+                    .arg(method).arg(id).arg(requestId);
+
+    return json.toLatin1();
+}
+
+// jsonRpcRequest()で作った要求をまとめ、1回の往復で送れる様にする
+QByteArray PeercastClient::jsonRpcBatch(const QList<QByteArray>& requests)
+{
+    QByteArray json("[");
+    for(int i=0; i < requests.size(); ++i) {
+        if( i > 0 ) json += ", ";
+        json += requests[i];
+    }
+    json += "]";
+
+    return json;
+}
+
+// 応答からrequestIdに対応するresultのパスを返す。見つからない場合は空文字列を返す
+QString PeercastClient::jsonRpcResultPath(const JsonReader& json, int requestId)
+{
+    return jsonRpcMemberPath(json, requestId, "result");
+}
+
+// 応答からrequestIdに対応するerrorのパスを返す。見つからない場合は空文字列を返す
+QString PeercastClient::jsonRpcErrorPath(const JsonReader& json, int requestId)
+{
+    return jsonRpcMemberPath(json, requestId, "error");
+}
+
+// 単独の応答、バッチの応答のどちらも扱う。
+// バッチの応答の順序は要求の順序と一致するとは限らない為、idで照合する
+QString PeercastClient::jsonRpcMemberPath(const JsonReader& json, int requestId, const QString& member)
+{
+    int size = json.arraySize(QString());
+
+    if( size == -1 ) {
+        if( json.toInt("id") == requestId && json.contains(member) )
+            return member;
+    }
+    else {
+        for(int i=0; i < size; ++i) {
+            if( json.toInt(QString("%1.id").arg(i)) == requestId ) {
+                QString path = QString("%1.%2").arg(i).arg(member);
+                if( json.contains(path) )
+                    return path;
+                break;
+            }
+        }
+    }
+
+    return QString();
+}
+
+// タイマーはreplyの子にし、replyの削除と共に消す
+QNetworkReply* PeercastClient::startTimeout(QNetworkReply* reply, int timeoutMsec)
+{
+    if( timeoutMsec > 0 ) {
+        QTimer* timer = new QTimer(reply);
+        timer->setSingleShot(true);
+        connect(timer, SIGNAL(timeout()), reply, SLOT(abort()));
+        timer->start(timeoutMsec);
+    }
+
+    return reply;
+}
@@ -0,0 +1,64 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PEERCASTCLIENT_H
+#define PEERCASTCLIENT_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class JsonReader;
+
+// PeerCastへのHTTPリクエストを送る。host:port毎に1つを全てのタスクで共有し、
+// QNetworkAccessManagerも全体で1つにして接続を使い回す。
+// 返したQNetworkReplyのfinished()は、タイムアウトで中止した場合も発行される。
+// QNetworkReplyの削除は受け取った側で行う
+class PeercastClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum { DEFAULT_TIMEOUT = 10000 };   // ms
+
+    static PeercastClient* client(const QString& host, ushort port);
+
+    QNetworkReply* get(const QString& pathAndQuery, int timeoutMsec=DEFAULT_TIMEOUT,
+                       bool pipelining=true);
+    QNetworkReply* postJsonRpc(const QByteArray& json, int timeoutMsec=DEFAULT_TIMEOUT);
+
+    static QByteArray jsonRpcRequest(const QString& method, const QString& id=QString(),
+                                     int requestId=1);
+    static QByteArray jsonRpcBatch(const QList<QByteArray>& requests);
+    static QString    jsonRpcResultPath(const JsonReader& json, int requestId=1);
+    static QString    jsonRpcErrorPath(const JsonReader& json, int requestId=1);
+
+private:
+    PeercastClient(const QString& host, ushort port, QObject* parent);
+
+    QNetworkReply* startTimeout(QNetworkReply* reply, int timeoutMsec);
+
+    static QString jsonRpcMemberPath(const JsonReader& json, int requestId, const QString& member);
+
+    static QNetworkAccessManager* s_nam;
+    static QHash<QString, PeercastClient*> s_clients;   // "host:port"をキーとする
+
+    QString _baseUrl;
+};
+
+#endif // PEERCASTCLIENT_H
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PLAYBACKTELEMETRY_H
+#define PLAYBACKTELEMETRY_H
+
+#include <QString>
+
+// 再生中に頻繁に変化する表示値を保持する。
+// 値が変化した項目を記録し、表示の更新時にまとめて取り出す。
+class PlaybackTelemetry
+{
+public:
+    enum { DISPLAY_INTERVAL = 33 }; // 表示の更新間隔(ms)
+
+    enum FIELD {
+        FIELD_TIME      = 0x01,     // 経過時間(秒)
+        FIELD_POSITION  = 0x02,     // シークバー位置(0.1秒単位)
+        FIELD_FRAME     = 0x04,     // フレーム数
+        FIELD_INFO_TEXT = 0x08,     // ステータスバーの情報テキスト(キャッシュ量等)
+    };
+
+    PlaybackTelemetry() { clear(); }
+
+    void clear();
+    void setTime(int sec)                   { set(&_time, sec, FIELD_TIME); }
+    void setPosition(double sec)            { set(&_position, (int)(sec * 10), FIELD_POSITION); }
+    void setFrame(int frame)                { set(&_frame, frame, FIELD_FRAME); }
+    void setInfoText(const QString& text);
+
+    int            time() const             { return _time; }
+    double         position() const         { return _position / 10.0; }
+    int            frame() const            { return _frame; }
+    const QString& infoText() const         { return _infoText; }
+
+    bool isDirty() const                    { return _dirtyFields != 0; }
+    int  takeDirtyFields()                  { int f = _dirtyFields; _dirtyFields = 0; return f; }
+
+private:
+    void set(int* field, int value, FIELD flag);
+
+    int     _dirtyFields;
+    int     _time;
+    int     _position;
+    int     _frame;
+    QString _infoText;
+};
+
+// 表示中の値が不明になった場合に呼ぶ。次に設定された値は必ず変化扱いになる
+inline void PlaybackTelemetry::clear()
+{
+    _dirtyFields = 0;
+    _time = -1;
+    _position = -1;
+    _frame = -1;
+    _infoText = QString();
+}
+
+inline void PlaybackTelemetry::setInfoText(const QString& text)
+{
+    if( text != _infoText || _infoText.isNull() ) {
+        _infoText = text;
+        _dirtyFields |= FIELD_INFO_TEXT;
+    }
+}
+
+inline void PlaybackTelemetry::set(int* field, int value, FIELD flag)
+{
+    if( value != *field ) {
+        *field = value;
+        _dirtyFields |= flag;
+    }
+}
+
+#endif // PLAYBACKTELEMETRY_H
@@ -19,12 +19,16 @@
 #include <QMimeData>
 #include <QFile>
 #include <QDir>
+#include <QFileInfo>
 #include <QUrl>
+#include <QHash>
 #include <QColor>
 #include <QMessageBox>
 #include <QDebug>
 #include "playlist.h"
 #include "commonlib.h"
+#include "identifycache.h"
+#include "durationprober.h"
 
 PlaylistModel::Track::Track(const QString& path, const QString& title, int duration)
 {
@@ -56,6 +60,10 @@ PlaylistModel::PlaylistModel(QObject* parent) : QAbstractTableModel(parent)
     _currentTrack = NULL;
     _loopPlay     = false;
     _randomPlay   = false;
+
+    _prober = new DurationProber(this);
+    connect(_prober, SIGNAL(probed(const QStringList&, const QList<int>&)),
+            this,    SLOT(prober_probed(const QStringList&, const QList<int>&)));
 }
 
 PlaylistModel::~PlaylistModel()
@@ -322,6 +330,7 @@ bool PlaylistModel::removeRows(int row, int count, const QModelIndex& parent)
         if( _randomPlay )
             _randomTracks.removeOne(track);
 
+        _prober->cancel(track->path);
         delete track;
         _tracks.removeAt(row);
     }
@@ -666,6 +675,35 @@ QString PlaylistModel::trackPath(int row)
     return QString();
 }
 
+// upCurrentTrackRow()で次に移るトラックのパスを返す。
+// ランダム再生で一巡した場合等、次のトラックが決まらない場合は空を返す
+QString PlaylistModel::nextTrackPath()
+{
+    if( _currentTrack == NULL ) return QString();
+
+    int i;
+    if( _randomPlay ) {
+        i = _randomTracks.indexOf(_currentTrack) + 1;
+        if( i <= 0 || i >= _randomTracks.size() )
+            return QString();
+
+        return _randomTracks[i]->path;
+    }
+
+    i = _tracks.indexOf(_currentTrack) + 1;
+    if( i <= 0 )
+        return QString();
+
+    if( i >= _tracks.size() ) {
+        if( _loopPlay )
+            i = 0;
+        else
+            return QString();
+    }
+
+    return _tracks[i]->path;
+}
+
 void PlaylistModel::setCurrentTrackTitle(const QString& title)
 {
     int i = _tracks.indexOf(_currentTrack);
@@ -703,10 +741,47 @@ void PlaylistModel::setRandomPlay(bool b)
     }
     else
         _randomTracks.clear();
+
+    emit playOrderChanged();
+}
+
+// 取得した再生時間を同じパスの全ての行へ反映し、連続した行毎にdataChanged()を発行する。
+// 次回から取得せずに済む様、IdentifyCacheにも保存する
+void PlaylistModel::prober_probed(const QStringList& paths, const QList<int>& durations)
+{
+    QHash<QString, int> durationOfPath;
+    for(int i=0; i < paths.size(); ++i) {
+        durationOfPath.insert(paths[i], durations[i]);
+
+        IdentifyCache::Entry entry;
+        entry.length = durations[i];
+        entry.lengthOnly = true;
+        IdentifyCache::store(paths[i], entry);
+    }
+
+    QList<int> rows;
+    for(int i=0; i < _tracks.size(); ++i) {
+        QHash<QString, int>::const_iterator it = durationOfPath.constFind(_tracks[i]->path);
+        if( it == durationOfPath.constEnd() || _tracks[i]->duration >= 0 )
+            continue;
+
+        _tracks[i]->setTime(*it);
+        rows << i;
+    }
+
+    for(int i=0; i < rows.size(); ) {
+        int first = rows[i];
+        int last = first;
+        while( ++i < rows.size() && rows[i] == last+1 )
+            last = rows[i];
+
+        emit dataChanged(PlaylistModel::index(first, COLUMN_TIME), PlaylistModel::index(last, COLUMN_TIME));
+    }
 }
 
 void PlaylistModel::removeAllRows()
 {
+    _prober->cancelAll();
     qDeleteAll(_tracks);
     _tracks.clear();
     _randomTracks.clear();
@@ -854,6 +929,13 @@ int PlaylistModel::insertTracks(int row, QList<Track*>& inTracks, bool* removedT
 
     endInsertRows();
 
+    // 再生時間が不明なローカルファイルは、バックグラウンドで取得する。
+    // ファイルの有無はDurationProberのスレッドで調べる
+    foreach(Track* track, inTracks) {
+        if( track->duration < 0 && QUrl(track->path).scheme().isEmpty() )
+            _prober->probe(track->path);
+    }
+
     // 初めからトラックが1件もない場合
     if( _currentTrack == NULL ) {
         if( _randomPlay )
@@ -893,15 +975,21 @@ QList<PlaylistModel::Track*> PlaylistModel::createTracks(QStringList paths)
 
         QDir dir(path);
         if( dir.exists() ) {
-            QStringList files = dir.entryList(QString(CommonLib::MEDIA_FORMATS).split(" "),
-                                              QDir::Files);
-            foreach(const QString& file, files)
-                tracks << new Track(dir.absoluteFilePath(file), file);
+            QFileInfoList files = dir.entryInfoList(QString(CommonLib::MEDIA_FORMATS).split(" "),
+                                                    QDir::Files);
+            foreach(const QFileInfo& file, files) {
+                QString filePath = dir.absoluteFilePath(file.fileName());
+                tracks << new Track(filePath, file.fileName(), cachedDuration(filePath, file));
+            }
         }
         else {
             QString title;
-            if( QFile::exists(path) )
+            int duration = -1;
+            QFileInfo info(path);
+            if( info.exists() ) {
                 title = path.split("/").last();
+                duration = cachedDuration(path, info);
+            }
             else {
                 if( path.indexOf(QRegExp("^\\s*$")) != -1 )
                     continue;
@@ -909,13 +997,24 @@ QList<PlaylistModel::Track*> PlaylistModel::createTracks(QStringList paths)
                 title = path;
             }
 
-            tracks << new Track(path, title);
+            tracks << new Track(path, title, duration);
         }
     }
 
     return tracks;
 }
 
+// 以前に再生したローカルファイルは、再生時間をIdentifyCacheから得る。
+// infoはエントリ一覧等で得たstat済みのものを渡す
+int PlaylistModel::cachedDuration(const QString& path, const QFileInfo& info)
+{
+    IdentifyCache::Entry entry;
+    if( IdentifyCache::find(path, info, &entry) )
+        return (int)entry.length;
+
+    return -1;
+}
+
 void PlaylistModel::shuffleRandomTracks()
 {
     for(int i=0; i < _randomTracks.size()-1; ++i)
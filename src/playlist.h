@@ -20,6 +20,9 @@
 #include <QTreeView>
 #include "commonlib.h"
 
+class QFileInfo;
+class DurationProber;
+
 class PlaylistModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -85,6 +88,7 @@ public:
     QString     currentTrackTitle();
     QString     currentTrackPath();
     QString     trackPath(int row);
+    QString     nextTrackPath();
     void        setCurrentTrackTitle(const QString& title);
     void        setCurrentTrackTime(int sec);
     bool        loopPlay()   { return _loopPlay; }
@@ -92,19 +96,24 @@ public:
 
 public slots:
     void setCurrentTrackRow(const QModelIndex& index, bool specifiedUser) { if( index.isValid() ) setCurrentTrackRow(index.row(), specifiedUser); }
-    void setLoopPlay(bool b) { _loopPlay = b; }
+    void setLoopPlay(bool b) { _loopPlay = b; emit playOrderChanged(); }
     void setRandomPlay(bool b);
     void removeAllRows();
 
+protected slots:
+    void prober_probed(const QStringList& paths, const QList<int>& durations);
+
 //  void debug();
 //  void test();
 signals:
     void removedCurrentTrack();
     void fluctuatedIndexDigit();
+    void playOrderChanged();        // ループ、ランダム再生の切り替え
 
 protected:
     int insertTracks(int row, QList<Track*>& tracks, bool* removedTrackByMaximum=0);
     QList<Track*> createTracks(QStringList paths);
+    static int cachedDuration(const QString& path, const QFileInfo& info);
     void shuffleRandomTracks();
 
 private:
@@ -116,6 +125,8 @@ private:
     bool    _loopPlay;
     bool    _randomPlay;
 
+    DurationProber* _prober;
+
     CommonLib::EmitDeterFlag _emitFlag;
 };
 
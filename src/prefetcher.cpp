@@ -0,0 +1,118 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QFile>
+#include <QRunnable>
+#include "prefetcher.h"
+#include "metrics.h"
+#include "logdialog.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace {
+
+class PrefetchJob : public QRunnable
+{
+public:
+    PrefetchJob(const QString& path, qint64 budget, QSharedPointer<QAtomicInt> canceled)
+        : _path(path), _budget(budget), _canceled(canceled) {}
+
+    void run();
+
+private:
+    QString                    _path;
+    qint64                     _budget;
+    QSharedPointer<QAtomicInt> _canceled;
+};
+
+void PrefetchJob::run()
+{
+    if( *_canceled != 0 )
+        return;
+
+    QFile file(_path);
+    if( !file.open(QIODevice::ReadOnly) )
+        return;
+
+    qint64 startTime = Metrics::now();
+    qint64 size = qMin(_budget, file.size());
+
+#ifdef Q_OS_LINUX
+    // ローカルのファイルシステムはこれで先読みされる。
+    // ネットワーク上のファイルシステムで効かない場合に備え、続けて実際に読む
+    posix_fadvise(file.handle(), 0, size, POSIX_FADV_WILLNEED);
+#endif
+
+    QByteArray buffer(Prefetcher::CHUNK_SIZE, 0);
+    qint64 done = 0;
+    while( done < size ) {
+        if( *_canceled != 0 ) {
+            Metrics::count("prefetch.canceled");
+            Metrics::count("prefetch.bytes", done);
+            return;
+        }
+
+        qint64 n = file.read(buffer.data(), qMin((qint64)buffer.size(), size - done));
+        if( n <= 0 )
+            break;
+
+        done += n;
+    }
+
+    Metrics::count("prefetch.bytes", done);
+    Metrics::sample("prefetch.duration_ms", Metrics::elapsedMsec(startTime));
+    LogDialog::debug(QString("PrefetchJob::run(): %1 bytes %2").arg(done).arg(_path));
+}
+
+}
+
+Prefetcher::Prefetcher(QObject* parent) : QObject(parent)
+{
+    _pool.setMaxThreadCount(1);
+    _budget = 0;
+}
+
+Prefetcher::~Prefetcher()
+{
+    cancel();
+    _pool.waitForDone();
+}
+
+// 同じファイルを指定した場合は何もしない
+void Prefetcher::prefetch(const QString& path)
+{
+    if( path == _path )
+        return;
+
+    cancel();
+
+    if( path.isEmpty() || _budget <= 0 )
+        return;
+
+    _path = path;
+    _canceled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    _pool.start(new PrefetchJob(path, _budget, _canceled));
+}
+
+void Prefetcher::cancel()
+{
+    if( !_canceled.isNull() )
+        _canceled->fetchAndStoreOrdered(1);
+
+    _canceled.clear();
+    _path.clear();
+}
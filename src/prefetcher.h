@@ -0,0 +1,48 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+// 次に再生するファイルの先頭をワーカースレッドで読み、ページキャッシュに載せておく。
+// 同時に読むファイルは1つまでで、別のファイルを指定すると前の読み込みは中止する。
+class Prefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum { CHUNK_SIZE = 256 * 1024 };
+
+    Prefetcher(QObject* parent);
+    ~Prefetcher();
+
+    void setBudget(qint64 bytes) { _budget = bytes; }
+    void prefetch(const QString& path);
+    void cancel();
+
+private:
+    QThreadPool                _pool;
+    QString                    _path;
+    QSharedPointer<QAtomicInt> _canceled;
+    qint64                     _budget;     // ファイル毎に読む最大バイト数
+};
+
+#endif // PREFETCHER_H
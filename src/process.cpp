@@ -15,6 +15,8 @@
 */
 #include "process.h"
 #include "logdialog.h"
+#include "metrics.h"
+#include "processtree.h"
 
 #ifdef Q_OS_WIN32
 #include <QTextCodec>
@@ -24,33 +26,50 @@ CommonProcess::CommonProcess(QObject* parent) : QProcess(parent)
 {
     setProcessChannelMode(QProcess::MergedChannels);
 
+#ifdef Q_OS_WIN32
+    _codec = QTextCodec::codecForName("SJIS");
+#endif
+
     connect(this, SIGNAL(readyReadStandardOutput()),
             this, SLOT(slot_readyReadStandardOutput()));
 }
 
+void CommonProcess::setMetricsName(const QString& name)
+{
+    _sampleReadBytes.setName(name + ".read.bytes");
+    _sampleReadLines.setName(name + ".read.lines");
+}
+
 void CommonProcess::slot_readyReadStandardOutput()
 {
-#ifdef Q_OS_WIN32
-    QByteArray ba = readAllStandardOutput();
-    QString out = QTextCodec::codecForName("SJIS")->toUnicode(ba);
+    // 出力をリングバッファへ直接読み込み、完成した行のみ文字列に変換する。
+    // 未完成の行はバッファに残り、次回の読み込み時に続きが連結される。
+    // 各行には読み込んだ時刻(Metrics::now())を付ける。
+    do {
+        int bytes = _outputBuff.readFrom(this);
+        qint64 receivedTime = Metrics::now();
+        int lines = 0;
+
+        const char* line;
+        int size;
+        while( _outputBuff.takeLine(&line, &size) ) {
+            QString out = decodeLine(line, size);
+            emit outputLine(out, receivedTime);
+            ++lines;
+        }
 
-    out.replace("\r\n", "\n");
+        _sampleReadBytes.add(bytes, receivedTime);
+        _sampleReadLines.add(lines, receivedTime);
+    } while( bytesAvailable() > 0 );
+}
+
+QString CommonProcess::decodeLine(const char* line, int size)
+{
+#ifdef Q_OS_WIN32
+    return _codec->toUnicode(line, size);
 #else
-    QString out = readAllStandardOutput();
+    return QString::fromAscii(line, size);
 #endif
-
-    out = _outputTempBuff + out.replace('\r', '\n');
-    QStringList lines = out.split("\n");
-
-    if( out[out.size()-1] != '\n' )
-        _outputTempBuff = lines.last();
-    else
-        _outputTempBuff = "";
-
-    lines.removeLast();
-
-    for(int i=0; i < lines.size(); ++i)
-        emit outputLine(lines[i]);
 }
 
 // ---------------------------------------------------------------------------------------
@@ -60,6 +79,8 @@ MplayerProcess::MplayerProcess(QObject* parent) : CommonProcess(parent)
             this, SLOT(slot_finished(int, QProcess::ExitStatus)));
 
     _mplayerCPid = 0;
+
+    setMetricsName("mplayer");
 }
 
 void MplayerProcess::receiveMplayerChildProcess()
@@ -67,56 +88,13 @@ void MplayerProcess::receiveMplayerChildProcess()
 #if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
     const QString debugPrefix = "MplayerProcess::receiveMplayerChildProcess(): ";
     // mplayerプロセスの子プロセスIDを取得する。mplayerバグ対策用
-    QProcess p;
-//  p.start("pgrep", QStringList() << "-P" << QString("%1").arg(pid()));
-    p.start("ps", QStringList() << "-o" << "pid" << "--no-headers"
-                                << QString("--ppid=%1").arg(pid()));
-
-    if( p.waitForFinished() ) {
-        QString cpid = p.readLine();
-        _mplayerCPid = cpid.toInt();
-    }
-    else
-        _mplayerCPid = 0;
+    _mplayerCPid = ProcessTree::children(pid()).value(0, 0);
 
     LogDialog::debug(debugPrefix + QString("pid %1").arg(pid()));
     LogDialog::debug(debugPrefix + QString("cpid %1").arg(_mplayerCPid));
 #endif
 }
 
-bool MplayerProcess::terminateWaitForFinished()
-{
-    const QString debugPrefix = "MplayerProcess::terminateWaitForFinished(): ";
-    LogDialog::debug(debugPrefix + "called");
-
-//  closeReadChannel(QProcess::StandardOutput);
-
-    QProcess::ProcessState status = state();
-    if( status == QProcess::Running ) {
-        command("quit");
-        if( waitForFinished(1000) )
-            return true;
-    }
-    else
-    if( status == QProcess::NotRunning ) {
-        LogDialog::debug(debugPrefix + "process not running");
-        return false;
-    }
-    else
-        LogDialog::debug(debugPrefix + "process starting", QColor(0,255,0));
-
-    LogDialog::debug(debugPrefix + "terminate()", QColor(255,0,0));
-    terminate();
-    bool ret = waitForFinished(3000);
-    if( !ret ) {
-        LogDialog::debug(debugPrefix + "kill()", QColor(255,0,0));
-        kill();
-        ret = waitForFinished(2000);
-    }
-
-    return ret;
-}
-
 void MplayerProcess::slot_finished(int /*exitCode*/, QProcess::ExitStatus /*exitStatus*/)
 {
     const QString debugPrefix = "MplayerProcess::slot_finished(): ";
@@ -125,25 +103,16 @@ void MplayerProcess::slot_finished(int /*exitCode*/, QProcess::ExitStatus /*exit
 #if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
     // mplayer子プロセスが残ってる場合終了させる
     if( _mplayerCPid != 0 ) {
-        QProcess p;
-        p.start("sh", QStringList() << "-c"
-                                    << QString("ps --no-headers p %1|grep -F '%2'")
-                                                    .arg(_mplayerCPid).arg(_path));
-        if( p.waitForFinished() ) {
-            QString s = p.readAllStandardOutput();
-            LogDialog::debug(debugPrefix + "ps cpid " + s);
-
-            if( !s.isEmpty() ) { // 子プロセスが存在しているなら
-                p.start("kill", QStringList() << QString("%1").arg(_mplayerCPid));
-                p.waitForFinished();
-                LogDialog::debug(debugPrefix + QString("terminated cpid %1 -------------")
-                                                    .arg(_mplayerCPid), QColor(255,0,0));
+        if( ProcessTree::isAlive(_mplayerCPid, _path) ) { // 子プロセスが存在しているなら
+            LogDialog::debug(debugPrefix + "cpid " + ProcessTree::commandLine(_mplayerCPid));
+
+            ProcessTree::terminate(_mplayerCPid);
+            LogDialog::debug(debugPrefix + QString("terminated cpid %1 -------------")
+                                                .arg(_mplayerCPid), QColor(255,0,0));
 
 #ifndef QT_NO_DEBUG_OUTPUT
-                emit debugKilledCPid();
+            emit debugKilledCPid();
 #endif // QT_NO_DEBUG_OUTPUT
-
-            }
         }
 
         _mplayerCPid = 0;
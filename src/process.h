@@ -18,6 +18,10 @@
 
 #include <QProcess>
 #include <QString>
+#include "linebuffer.h"
+#include "metrics.h"
+
+class QTextCodec;
 
 class CommonProcess : public QProcess
 {
@@ -27,14 +31,23 @@ public:
     CommonProcess(QObject* parent);
     virtual ~CommonProcess() {}
 
+    void setMetricsName(const QString& name);
+
 signals:
-    void outputLine(const QString& line);
+    void outputLine(const QString& line, qint64 receivedTime);
 
 private slots:
     void slot_readyReadStandardOutput();
 
 private:
-    QString _outputTempBuff;
+    QString decodeLine(const char* line, int size);
+
+    LineBuffer     _outputBuff;
+    MetricsSampler _sampleReadBytes;    // setMetricsName()した場合、読み込み量を記録する
+    MetricsSampler _sampleReadLines;
+#ifdef Q_OS_WIN32
+    QTextCodec* _codec;
+#endif
 };
 
 class MplayerProcess : public CommonProcess
@@ -47,8 +60,6 @@ public:
     void receiveMplayerChildProcess();
     void command(const QString& command) { write(command.toLocal8Bit() + "\n"); }
 
-    bool terminateWaitForFinished();
-
 signals:
     void finished();
     void debugKilledCPid();     // debug
@@ -0,0 +1,154 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "processtree.h"
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
+#include <sys/types.h>
+#include <signal.h>
+#include <errno.h>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+
+namespace {
+
+#ifdef Q_OS_LINUX
+QByteArray readProcFile(const QString& path)
+{
+    QFile file(path);
+    if( !file.open(QIODevice::ReadOnly) )
+        return QByteArray();
+
+    return file.readAll(); // /procのファイルはサイズが0なので、readAll()で末尾まで読む
+}
+
+void appendPids(const QByteArray& text, QList<Q_PID>* pids)
+{
+    foreach(const QByteArray& s, text.simplified().split(' ')) {
+        bool ok;
+        Q_PID pid = s.toLongLong(&ok);
+        if( ok )
+            pids->append(pid);
+    }
+}
+
+// /proc/<pid>/statの4番目の項目が親プロセスID。
+// 2番目の項目(コマンド名)は空白や括弧を含み得るので、最後の')'以降を分割する
+Q_PID parentPid(const QString& pid)
+{
+    QByteArray stat = readProcFile("/proc/" + pid + "/stat");
+    int index = stat.lastIndexOf(')');
+    if( index == -1 )
+        return 0;
+
+    QList<QByteArray> fields = stat.mid(index + 1).simplified().split(' ');
+    return fields.value(1).toLongLong();
+}
+#endif // Q_OS_LINUX
+
+}
+
+QList<Q_PID> ProcessTree::children(Q_PID pid)
+{
+    QList<Q_PID> pids;
+
+#ifdef Q_OS_LINUX
+    // 各スレッドのchildrenを読む
+    QDir taskDir(QString("/proc/%1/task").arg(pid));
+    bool found = false;
+    foreach(const QString& tid, taskDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile file(taskDir.filePath(tid + "/children"));
+        if( !file.open(QIODevice::ReadOnly) )
+            continue;
+
+        found = true;
+        appendPids(file.readAll(), &pids);
+    }
+
+    // childrenが無いカーネルの場合は、全プロセスの親プロセスIDを調べる
+    if( !found && taskDir.exists() ) {
+        QDir procDir("/proc");
+        foreach(const QString& name, procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            bool ok;
+            Q_PID child = name.toLongLong(&ok);
+            if( ok && parentPid(name) == pid )
+                pids.append(child);
+        }
+    }
+#else
+    QProcess p;
+    p.start("ps", QStringList() << "-o" << "pid" << "--no-headers"
+                                << QString("--ppid=%1").arg(pid));
+    if( p.waitForFinished() ) {
+        foreach(const QString& s, QString(p.readAllStandardOutput()).split('\n', QString::SkipEmptyParts)) {
+            bool ok;
+            Q_PID child = s.trimmed().toLongLong(&ok);
+            if( ok )
+                pids.append(child);
+        }
+    }
+#endif
+
+    return pids;
+}
+
+QString ProcessTree::commandLine(Q_PID pid)
+{
+#ifdef Q_OS_LINUX
+    QByteArray cmdline = readProcFile(QString("/proc/%1/cmdline").arg(pid));
+    cmdline.replace('\0', ' ');
+    return QString::fromLocal8Bit(cmdline).trimmed();
+#else
+    QProcess p;
+    p.start("ps", QStringList() << "-o" << "command=" << "-p" << QString::number(pid));
+    if( p.waitForFinished() )
+        return QString::fromLocal8Bit(p.readAllStandardOutput()).trimmed();
+
+    return QString();
+#endif
+}
+
+// programが空でない場合、コマンドラインにprogramを含むプロセスのみ生存とみなす。
+// (終了後にプロセスIDが再利用された場合の誤判定対策)
+// ゾンビプロセスはコマンドラインが空なので生存とみなさない。
+bool ProcessTree::isAlive(Q_PID pid, const QString& program)
+{
+    if( pid <= 0 )
+        return false;
+
+#ifdef Q_OS_LINUX
+    QString cmdline = commandLine(pid);
+    if( cmdline.isEmpty() )
+        return false;
+
+    return program.isEmpty() || cmdline.contains(program);
+#else
+    if( ::kill(pid, 0) != 0 && errno != EPERM )
+        return false;
+
+    return program.isEmpty() || commandLine(pid).contains(program);
+#endif
+}
+
+bool ProcessTree::terminate(Q_PID pid)
+{
+    if( pid <= 0 )
+        return false;
+
+    return ::kill(pid, SIGTERM) == 0;
+}
+
+#endif // defined(Q_OS_LINUX) || defined(Q_OS_MAC)
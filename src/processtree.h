@@ -0,0 +1,35 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PROCESSTREE_H
+#define PROCESSTREE_H
+
+#include <QList>
+#include <QString>
+#include <QProcess>
+
+// プロセスの親子関係の取得と、シグナルの送信。
+// Linuxでは/procを直接読み、外部コマンドを起動しない。
+namespace ProcessTree
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC)
+QList<Q_PID> children(Q_PID pid);
+QString      commandLine(Q_PID pid);    // 引数は空白で区切る。取得できない場合は空
+bool         isAlive(Q_PID pid, const QString& program=QString());
+bool         terminate(Q_PID pid);
+#endif
+}
+
+#endif // PROCESSTREE_H
@@ -18,9 +18,14 @@
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
-#include <QScriptEngine>
 #include "pureplayer.h"
 #include "process.h"
+#include "mplayeroutputparser.h"
+#include "mplayerworker.h"
+#include "seekscheduler.h"
+#include "prefetcher.h"
+#include "identifycache.h"
+#include "metrics.h"
 #include "controlbutton.h"
 #include "timeslider.h"
 #include "infolabel.h"
@@ -98,6 +103,9 @@ PurePlayer::PurePlayer(QWidget* parent) : QMainWindow(parent)
     _volumeFactor = VF_NORMAL;
     _aspectRatio = AR_VIDEO;
     _deinterlace = DI_NO_DEINTERLACE;
+    _launchAudioOutput = AO_STEREO;
+    _launchDeinterlace = DI_NO_DEINTERLACE;
+    _chainAudioOutput = AO_STEREO;
     _videoSize = QSize(-1, -1);
     _clipRect = QRect(0,0, 1,1);
     _fileFormat = "";
@@ -112,18 +120,46 @@ PurePlayer::PurePlayer(QWidget* parent) : QMainWindow(parent)
     connect(&_peercast, SIGNAL(gotChannelInfo(const ChannelInfo&)),
             this,       SLOT(peercast_gotChannelInfo(const ChannelInfo&)));
 
-    _mpProcess = new MplayerProcess(this);
-    connect(_mpProcess, SIGNAL(outputLine(const QString&)),
-            this,       SLOT(mpProcess_outputLine(const QString&)));
-    connect(_mpProcess, SIGNAL(finished()),
-            this,       SLOT(mpProcess_finished()));
-    connect(_mpProcess, SIGNAL(error(QProcess::ProcessError)),
-            this,       SLOT(mpProcess_error(QProcess::ProcessError)));
-//  connect(_mpProcess, SIGNAL(debugKilledCPid()),
-//          this,       SLOT(mpProcess_debugKilledCPid()));
+    _mpClient = new MplayerClient(this);
+    connect(_mpClient, SIGNAL(statusBatch(const MplayerStatusBatch&)),
+            this,      SLOT(mpClient_statusBatch(const MplayerStatusBatch&)));
+    connect(_mpClient, SIGNAL(messageLine(const QString&)),
+            this,      SLOT(mpClient_messageLine(const QString&)));
+    connect(_mpClient, SIGNAL(identifyInfo(int, const QString&)),
+            this,      SLOT(mpClient_identifyInfo(int, const QString&)));
+    connect(_mpClient, SIGNAL(cacheUnderrun()),
+            this,      SLOT(mpClient_cacheUnderrun()));
+    connect(_mpClient, SIGNAL(connecting()),
+            this,      SLOT(mpClient_connecting()));
+    connect(_mpClient, SIGNAL(cacheSizeSet()),
+            this,      SLOT(mpClient_cacheSizeSet()));
+    connect(_mpClient, SIGNAL(cacheFill(double)),
+            this,      SLOT(mpClient_cacheFill(double)));
+    connect(_mpClient, SIGNAL(generatingIndex(int)),
+            this,      SLOT(mpClient_generatingIndex(int)));
+    connect(_mpClient, SIGNAL(videoOutputReady(const QString&, const QSize&)),
+            this,      SLOT(mpClient_videoOutputReady(const QString&, const QSize&)));
+    connect(_mpClient, SIGNAL(paused()),
+            this,      SLOT(mpClient_paused()));
+    connect(_mpClient, SIGNAL(timePosAnswered(double)),
+            this,      SLOT(mpClient_timePosAnswered(double)));
+    connect(_mpClient, SIGNAL(eof()),
+            this,      SLOT(mpClient_eof()));
+    connect(_mpClient, SIGNAL(queuedFileStarted()),
+            this,      SLOT(mpClient_queuedFileStarted()));
+    connect(_mpClient, SIGNAL(screenshotSaved(const QString&)),
+            this,      SLOT(mpClient_screenshotSaved(const QString&)));
+    connect(_mpClient, SIGNAL(screenshotFailed()),
+            this,      SLOT(mpClient_screenshotFailed()));
+    connect(_mpClient, SIGNAL(finished()),
+            this,      SLOT(mpClient_finished()));
+    connect(_mpClient, SIGNAL(error(QProcess::ProcessError)),
+            this,      SLOT(mpClient_error(QProcess::ProcessError)));
+//  connect(_mpClient, SIGNAL(debugKilledCPid()),
+//          this,      SLOT(mpClient_debugKilledCPid()));
 
     _recProcess = new RecordingProcess(this);
-    connect(_recProcess, SIGNAL(outputLine(const QString&)),
+    connect(_recProcess, SIGNAL(outputLine(const QString&, qint64)),
             this,        SLOT(recProcess_outputLine(const QString&)));
 //  connect(_recProcess, SIGNAL(finished()),
 //          this,        SLOT(recProcess_finished()));
@@ -137,13 +173,35 @@ PurePlayer::PurePlayer(QWidget* parent) : QMainWindow(parent)
     _reconnectControlTimeVo = 0;
     connect(&_timerReconnect, SIGNAL(timeout()), this, SLOT(timerReconnect_timeout()));
 
+    _trackStartTime = 0;
+    _lastStatusTime = 0;
+    _sampleGuiDelay.setName("telemetry.gui_delay_ms");
+    _sampleBatchLines.setName("telemetry.batch_lines");
+    _idleSession = false;
+
     _fpsCount = 0;
-    _oldFrame = 0;
     connect(&_timerFps, SIGNAL(timeout()), this, SLOT(timerFps_timeout()));
 
+    _seekScheduler = new SeekScheduler(this);
+    connect(_seekScheduler, SIGNAL(requestCommand(const QString&)), this, SLOT(mpCmd(const QString&)));
+
+    _timerTelemetry.setSingleShot(true);
+    _timerTelemetry.setInterval(PlaybackTelemetry::DISPLAY_INTERVAL);
+    connect(&_timerTelemetry, SIGNAL(timeout()), this, SLOT(updateTelemetryDisplay()));
+
     _playlist = new PlaylistModel(this);
     connect(_playlist, SIGNAL(removedCurrentTrack()), this, SLOT(stop()));
 
+    // 並べ替え等でまとめて発行されるシグナルは、プレイリストの更新が終わってから処理する
+    _prefetcher = new Prefetcher(this);
+    connect(_playlist, SIGNAL(playOrderChanged()), this, SLOT(updatePrefetch()), Qt::QueuedConnection);
+    connect(_playlist, SIGNAL(layoutChanged()), this, SLOT(updatePrefetch()), Qt::QueuedConnection);
+    connect(_playlist, SIGNAL(modelReset()), this, SLOT(updatePrefetch()), Qt::QueuedConnection);
+    connect(_playlist, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+            this,      SLOT(updatePrefetch()), Qt::QueuedConnection);
+    connect(_playlist, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+            this,      SLOT(updatePrefetch()), Qt::QueuedConnection);
+
     _openDialog        = NULL;
     _videoAdjustDialog = NULL;
     _configDialog      = NULL;
@@ -171,6 +229,7 @@ PurePlayer::~PurePlayer()
     delete statusBar()->style();
 
     Task::waitForFinished();
+    IdentifyCache::flush();
 }
 
 void PurePlayer::createStatusBar()
@@ -823,9 +882,15 @@ void PurePlayer::setCurrentDirectory()
 
 void PurePlayer::openCommonProcess(const QString& path)
 {
-    const QString debugPrefix = "PurePlayer::openCommonProcess(): ";
-
     stop();
+    setCurrentPath(path);
+    playCommonProcess();
+}
+
+// 再生するパスを切り替え、パスに応じた表示等を設定する
+void PurePlayer::setCurrentPath(const QString& path)
+{
+    const QString debugPrefix = "PurePlayer::setCurrentPath(): ";
 
     _path = path;
     if( !_pathForTitleOption.isNull() ) {
@@ -892,8 +957,6 @@ void PurePlayer::openCommonProcess(const QString& path)
 
     setCurrentDirectory();
     LogDialog::debug(debugPrefix + "current dir " + QDir::currentPath());
-
-    playCommonProcess();
 }
 
 void PurePlayer::stopPeercast()
@@ -956,18 +1019,9 @@ void PurePlayer::seek(double sec, bool relative)
 
     if( _state==ST_PLAY || _state==ST_PAUSE ) {
         if( relative )
-            mpCmd(QString().sprintf("seek %.1f 0", sec));
-        else {
-            if( sec < 0 )
-                sec = 0;
-            else if( sec > _videoLength )
-                sec = _videoLength;
-
-            double percent = sec / _videoLength * 100;
-            mpCmd(QString().sprintf("seek %.1f 1", percent));   // パーセントによる指定
-//          mpCmd(QString().sprintf("seek %d 2", sec));         // 時間による直接指定
-                                                     // mplayer1では時間直接指定にバグあり
-        }
+            _seekScheduler->seekRelative(sec);
+        else
+            _seekScheduler->seekAbsolute(sec);
     }
 }
 
@@ -1079,7 +1133,7 @@ void PurePlayer::mute(bool b)
     }
     else {
 //      cmd = "mute 0";
-        cmd = QString("volume %1 1").arg(_volume);
+        cmd = QString("volume %1 1").arg(mplayerVolume());
         text = "Unmute";
         p.setColor(_labelVolume->foregroundRole(), QColor(255,255,255));
     }
@@ -1118,13 +1172,13 @@ void PurePlayer::setVolume(int value)
 
     if( !isMute() ) {
         if( _state == ST_PLAY ) { //|| _state == ST_READY ) {
-            mpCmd(QString("volume %1 1").arg(_volume));
+            mpCmd(QString("volume %1 1").arg(mplayerVolume()));
             if( !_controlFlags.testFlag(FLG_HIDE_DISPLAY_MESSAGE) )
                 mpCmd(QString("osd_show_text %1").arg(_volume));
         }
         else
         if( _state == ST_PAUSE )
-            mpCmd(QString("pausing_keep_force volume %1 1").arg(_volume));
+            mpCmd(QString("pausing_keep_force volume %1 1").arg(mplayerVolume()));
     }
 
     _labelVolume->setText(QString::number(_volume));
@@ -1135,8 +1189,9 @@ void PurePlayer::setVolumeFactor(VOLUME_FACTOR_MODE mode)
     if( _volumeFactor != mode ) {
         _volumeFactor = mode;
 
-        if( !isStop() )
-            restartPlay(true);
+        _controlFlags |= FLG_HIDE_DISPLAY_MESSAGE;
+        setVolume(_volume);
+        _controlFlags &= ~FLG_HIDE_DISPLAY_MESSAGE;
 
         _actGroupVolumeFactor->actions()[mode]->setChecked(true);
     }
@@ -1147,8 +1202,8 @@ void PurePlayer::setAudioOutput(AUDIO_OUTPUT_MODE mode)
     if( _audioOutput != mode ) {
         _audioOutput = mode;
 
-        if( !isStop() )
-            restartPlay(true);
+        if( isPlaying() )
+            applyAudioOutputFilter();
 
         _actGroupAudioOutput->actions()[mode]->setChecked(true);
     }
@@ -1327,7 +1382,7 @@ void PurePlayer::setDeinterlace(DEINTERLACE_MODE mode)
     if( _deinterlace != mode ) {
         _deinterlace = mode;
 
-        if( !isStop() )
+        if( !isStop() && !applyDeinterlace() )
             restartPlay(true);
 
         _actGroupDeinterlace->actions()[mode]->setChecked(true);
@@ -2199,15 +2254,16 @@ void PurePlayer::closeAllOtherDialog()
         _clipWindow->close();
 }
 
-void PurePlayer::mpProcess_finished()
+void PurePlayer::mpClient_finished()
 {
-    const QString debugPrefix = "PurePlayer::mpProcess_finished(): ";
+    const QString debugPrefix = "PurePlayer::mpClient_finished(): ";
     LogDialog::print(QString("[%1]PurePlayer: mplayer process finished")
                         .arg(QTime::currentTime().toString()), QColor(106,129,198));
     LogDialog::debug(debugPrefix + QString("state finished with %1.").arg(_state));
 
     if( isPeercastStream() )
     {
+        updateTelemetryDisplay();
         _elapsedTime = _timeLabel->time();
         LogDialog::debug(debugPrefix + QString("elapsed time %1").arg(_elapsedTime));
 
@@ -2240,18 +2296,20 @@ void PurePlayer::mpProcess_finished()
         }
     }
     else {
-        if( !_controlFlags.testFlag(FLG_EOF) || !playNext() )
+        if( _controlFlags.testFlag(FLG_EOF) && playNext() )
+            _advanceGapMetric = "playlist.advance_gap_ms.restart";
+        else
             setStatus(ST_STOP);
     }
 
     LogDialog::debug(debugPrefix + "end");
 }
 
-void PurePlayer::mpProcess_error(QProcess::ProcessError error)
+void PurePlayer::mpClient_error(QProcess::ProcessError error)
 {
     if( error == QProcess::FailedToStart ) {
         setStatus(ST_STOP);
-        LogDialog::debug("PurePlayer::mpProcess_error(): mplayer not started.", QColor(255,0,0));
+        LogDialog::debug("PurePlayer::mpClient_error(): mplayer not started.", QColor(255,0,0));
         QMessageBox::warning(this, tr("エラー"),
                 tr("MPlayerを起動できませんでした。\n"
                    "起動にはMPlayerがインストールされており、\n"
@@ -2259,337 +2317,446 @@ void PurePlayer::mpProcess_error(QProcess::ProcessError error)
     }
 }
 
-void PurePlayer::mpProcess_outputLine(const QString& line)
-{
-    const QString debugPrefix = "PurePlayer::mpProcess_outputLine(): ";
-//  static QRegExp rxCacheSize("^Cache size set to (\\d+)");
-    static QRegExp rxCacheFill("^Cache fill: *([0-9.]+)%");
-    static QRegExp rxGenIndex("^Generating Index: *(\\d+)");
-    static QRegExp rxFileFormat("^(.+) file format detected.|^Detected file format: (.+)");
-//  static QRegExp rxVideoW("^ID_VIDEO_WIDTH=(\\d+)");
-//  static QRegExp rxVideoH("^ID_VIDEO_HEIGHT=(\\d+)");
-    static QRegExp rxVideoDriverWH("^VO: \\[(.+)\\] \\d+x\\d+ => (\\d+)x(\\d+)");
-    static QRegExp rxLength("^ID_LENGTH=([0-9.]+)");
-    static QRegExp rxSeekable("^ID_SEEKABLE=(\\d)");
-//  static QRegExp rxStartTime("^ID_START_TIME=([0-9.]+)");
-    static QRegExp rxTitle("^ title: (.+)");
-    static QRegExp rxAuthor("^ author: (.+)");
-    static QRegExp rxCopyright("^ copyright: (.+)");
-    static QRegExp rxComments("^ comments: (.+)");
-    static QRegExp rxStatus("^[AV]: *([0-9.-]+) (?:V: *([0-9.-]+))?");
-    static QRegExp rxFrame(".+ (\\d+)\\/ *\\d+");
-    static QRegExp rxScreenshot("^\\*\\*\\* screenshot '(.+)'");
-    static QRegExp rxScreenshotError(".+ Error opening .+ for writing!");
+// ステータス行の集約結果を受信した。
+// batch.firstは集約の最初のステータス、batch.lastは最新のステータス。
+void PurePlayer::mpClient_statusBatch(const MplayerStatusBatch& batch)
+{
+    const QString debugPrefix = "PurePlayer::mpClient_statusBatch(): ";
 
     if( isStop() ) // 再生停止時、溜まってる情報を一気に出力する場合があるので解析対象外にする
-    {
-        if( rxStatus.indexIn(line) != -1 )
-            return;
+        return;
 
-        LogDialog::print("ignore: " + line);
-    }
-    else
-    {
-        if( rxStatus.indexIn(line) != -1 )
-        {
-            if( _startTime == -1 ) {
-                if( isPeercastStream() ) {
-                    _startTime = rxStatus.cap(1).toDouble();
-
-                    if( _existAudio ) {
-                        _reconnectControlTimeAo = rxStatus.cap(1).toDouble();
-                        _reconnectControlTimeVo = rxStatus.cap(2).toDouble();
-                    }
-                    else
-                        _reconnectControlTimeVo = rxStatus.cap(1).toDouble();
-
-                    _timerChannelInfo.start();
-                }
-                else
-                    _startTime = 0;
+    const MplayerStatus& first  = batch.first;
+    const MplayerStatus& status = batch.last;
 
-                _oldTime = _startTime;
+    // GUIスレッドがパイプの読み込みに追いついているかの計測
+    _sampleGuiDelay.add(Metrics::elapsedMsec(status.receivedTime), status.receivedTime);
+    _sampleBatchLines.add(batch.count, status.receivedTime);
 
-#ifdef Q_WS_X11
-                if( _existVideo ) {
-                    _videoScreen->setAttribute(Qt::WA_NoSystemBackground);
-                    _videoScreen->setAttribute(Qt::WA_PaintOnScreen);
-                }
-#endif
-                LogDialog::debug(debugPrefix + QString("init startTime %1").arg(_startTime));
-            }
+    // 前のトラックの最後のステータスから、次のトラックの最初のステータスまでの間隔
+    if( !_advanceGapMetric.isEmpty() ) {
+        Metrics::sample(_advanceGapMetric, (first.receivedTime - _lastStatusTime) / 1000.0);
+        _advanceGapMetric.clear();
+    }
+    _lastStatusTime = status.receivedTime;
 
-            _currentTime = rxStatus.cap(1).toDouble();
+    if( _startTime == -1 ) {
+        if( isPeercastStream() ) {
+            _startTime = first.time;
 
             if( _existAudio ) {
-                _currentTimeAo = _currentTime;
-                _currentTimeVo = rxStatus.cap(2).toDouble();
+                _reconnectControlTimeAo = first.time;
+                _reconnectControlTimeVo = first.timeVo;
             }
             else
-                _currentTimeVo = _currentTime;
+                _reconnectControlTimeVo = first.time;
 
-            if( _currentTime > _startTime ) {
-                if( isPeercastStream() ) {
-                    double differenceTime = _currentTime - _oldTime;
+            _timerChannelInfo.start();
+        }
+        else
+            _startTime = 0;
 
-                    // 現在の取得時間が前の取得時間から大きく飛んだ場合、経過時間を無効にする
-                    // (再生開始時の古いキャッシュ再生による開始時間ズレの対応)
-                    if( differenceTime > 1 ) {
-                        LogDialog::debug(debugPrefix + QString("oldElapsed %1")
-                                            .arg(_elapsedTime), QColor(255,0,0));
+        _oldTime = _startTime;
 
-                        _elapsedTime += _oldTime - _startTime;
-                        _startTime = _currentTime;
+#ifdef Q_WS_X11
+        if( _existVideo ) {
+            _videoScreen->setAttribute(Qt::WA_NoSystemBackground);
+            _videoScreen->setAttribute(Qt::WA_PaintOnScreen);
+        }
+#endif
+        LogDialog::debug(debugPrefix + QString("init startTime %1").arg(_startTime));
+    }
 
-                        LogDialog::debug(debugPrefix + QString("elapsed %1").arg(_elapsedTime), QColor(255,0,0));
-                        LogDialog::debug(debugPrefix + QString("startTime %1").arg(_startTime), QColor(255,0,0));
-                        LogDialog::debug(debugPrefix + QString("diff %1 old %2").arg(differenceTime).arg(_oldTime), QColor(255,0,0));
-                    }
+    _currentTime = status.time;
+    _seekScheduler->statusTick(_currentTime);
+
+    if( _existAudio ) {
+        _currentTimeAo = _currentTime;
+        _currentTimeVo = status.timeVo;
+    }
+    else
+        _currentTimeVo = _currentTime;
 
-                    // 差分時間が特に大きい場合、再接続する
-                    // (差分時間が大きいとフレームがしばらく停止してしまう為)
-                    if( differenceTime > 10 ) {
-                        LogDialog::debug(debugPrefix + "reconnect diff", QColor(255,0,0));
+    if( _currentTime > _startTime ) {
+        if( isPeercastStream() ) {
+            double differenceTime = first.time - _oldTime;
 
-                        reconnectPurePlayer();
-                    }
-                }
-                else {
-                    // 2点間リピート処理
-                    if( _isSeekable
-                        && _repeatStartTime>=0 && _repeatEndTime>=0 )
-                    {
-                        if( (_currentTime >= _repeatEndTime/10.0
-                                && !_controlFlags.testFlag(FLG_SEEKED_REPEAT))
-                            || _currentTime >= _repeatEndTime/10.0 + 1 )
-                        {
-                            seek(_repeatStartTime/10.0);
-
-                            _controlFlags |= FLG_SEEKED_REPEAT;
-
-                            LogDialog::debug(debugPrefix + QString("old %1 current %2 end %3")
-                                .arg(_oldTime).arg(_currentTime).arg(_repeatEndTime/10.0));
-                        }
-                        else
-                        if( _currentTime < _repeatEndTime/10.0
-                            && _controlFlags.testFlag(FLG_SEEKED_REPEAT) )
-                        {
-                            _controlFlags &= ~FLG_SEEKED_REPEAT;
-                        }
-                    }
-                }
+            // 現在の取得時間が前の取得時間から大きく飛んだ場合、経過時間を無効にする
+            // (再生開始時の古いキャッシュ再生による開始時間ズレの対応)
+            if( differenceTime > 1 ) {
+                LogDialog::debug(debugPrefix + QString("oldElapsed %1")
+                                    .arg(_elapsedTime), QColor(255,0,0));
 
-                _oldTime = _currentTime;
+                _elapsedTime += _oldTime - _startTime;
+                _startTime = first.time;
 
-                double time = _currentTime - _startTime;
-                _timeLabel->setTime(time + _elapsedTime);
+                LogDialog::debug(debugPrefix + QString("elapsed %1").arg(_elapsedTime), QColor(255,0,0));
+                LogDialog::debug(debugPrefix + QString("startTime %1").arg(_startTime), QColor(255,0,0));
+                LogDialog::debug(debugPrefix + QString("diff %1 old %2").arg(differenceTime).arg(_oldTime), QColor(255,0,0));
+            }
 
-                if( _isSeekable ) {
-//                  if( time != _oldTime )
-                    _timeSlider->setPosition(time);
+            // 差分時間が特に大きい場合、再接続する
+            // (差分時間が大きいとフレームがしばらく停止してしまう為)
+            if( differenceTime > 10 ) {
+                LogDialog::debug(debugPrefix + "reconnect diff", QColor(255,0,0));
 
-//                  _oldTime = time;
-                }
+                reconnectPurePlayer();
             }
+        }
+        else {
+            // 2点間リピート処理
+            if( _isSeekable
+                && _repeatStartTime>=0 && _repeatEndTime>=0 )
+            {
+                if( (_currentTime >= _repeatEndTime/10.0
+                        && !_controlFlags.testFlag(FLG_SEEKED_REPEAT))
+                    || _currentTime >= _repeatEndTime/10.0 + 1 )
+                {
+                    seek(_repeatStartTime/10.0);
 
-            if( rxFrame.indexIn(line) != -1 ) {
-                _labelFrame->setText(rxFrame.cap(1));
+                    _controlFlags |= FLG_SEEKED_REPEAT;
 
-                uint currentFrame = rxFrame.cap(1).toInt();
-                if( currentFrame==0 || currentFrame!=_oldFrame ) {
-                    ++_fpsCount;
-                    _oldFrame = currentFrame;
+                    LogDialog::debug(debugPrefix + QString("old %1 current %2 end %3")
+                        .arg(_oldTime).arg(_currentTime).arg(_repeatEndTime/10.0));
+                }
+                else
+                if( _currentTime < _repeatEndTime/10.0
+                    && _controlFlags.testFlag(FLG_SEEKED_REPEAT) )
+                {
+                    _controlFlags &= ~FLG_SEEKED_REPEAT;
                 }
             }
 
-            if( _state == ST_PAUSE ) // ポーズが解除された場合
-                setStatus(ST_PLAY);
-
-//          if( time < 0 ) _outputStatusLog = true;
-            if( _outputStatusLog ) LogDialog::print(line + QString::number(_fpsCount));
-            return;
+            // 途切れずに次のトラックへ移る為、終了間際に次のトラックをmplayerへ追加しておく
+            if( _idleSession && _queuedNextPath.isEmpty() && _videoLength > 0
+                && _currentTime >= _videoLength - QUEUE_NEXT_TRACK_TIME )
+            {
+                queueNextTrack();
+            }
         }
 
-        LogDialog::print(line);
+        _oldTime = _currentTime;
 
-        if( line.startsWith("Cache empty") || line.startsWith("Cache not filling")
-         || line.contains("Bits overconsumption:") )
-        {
-            if( isPeercastStream() )
-                _reconnectScore += 100;
+        double time = _currentTime - _startTime;
+        _telemetry.setTime(time + _elapsedTime);
+
+        if( _isSeekable ) {
+//          if( time != _oldTime )
+            _telemetry.setPosition(time);
+
+//          _oldTime = time;
         }
-        else
-        if( (line.startsWith("Starting playback...") && !_existVideo)
-         || (rxVideoDriverWH.indexIn(line) != -1) )
-        {
-            setStatus(ST_PLAY);
+    }
+
+    if( status.frame >= 0 ) {
+        _telemetry.setFrame(status.frame);
+        _fpsCount += batch.frameCount;
+    }
 
-            if( isMute() )
-                mute(true);
+    if( _state == ST_PAUSE ) // ポーズが解除された場合
+        setStatus(ST_PLAY);
 
-            if( _speedRate != 1.0 )
-                setSpeedRate(_speedRate);
+//  if( time < 0 ) _outputStatusLog = true;
+    if( _outputStatusLog ) LogDialog::print(batch.lastLine + QString::number(_fpsCount));
 
-            _controlFlags |= FLG_HIDE_DISPLAY_MESSAGE; //mpCmd("osd 0");
+    requestTelemetryDisplay();
+}
 
-            setVolume(_volume);
-            setContrast(_videoProfile.contrast, true);
-            setBrightness(_videoProfile.brightness, true);
-            setSaturation(_videoProfile.saturation, true);
-            setHue(_videoProfile.hue, true);
-            setGamma(_videoProfile.gamma, true);
+void PurePlayer::mpClient_messageLine(const QString& line)
+{
+    if( isStop() )
+        LogDialog::print("ignore: " + line);
+    else
+        LogDialog::print(line);
+}
 
-            _controlFlags &= ~FLG_HIDE_DISPLAY_MESSAGE; //mpCmd("osd 1");
+void PurePlayer::mpClient_identifyInfo(int info, const QString& value)
+{
+    if( isStop() )
+        return;
 
-            // mplayerプロセスの子プロセスIDを取得する
-            _mpProcess->receiveMplayerChildProcess();
+    switch( info ) {
+    case MplayerOutputParser::INFO_LENGTH:
+        _videoLength = value.toDouble();
+        _seekScheduler->setLength(_videoLength);
+        break;
 
-            _timeLabel->setTotalTime(_videoLength);
-            _playlist->setCurrentTrackTime(_videoLength);
+    case MplayerOutputParser::INFO_SEEKABLE:
+        _isSeekable = value.toInt();
+        break;
 
-            if( _isSeekable ) {
-                _timeSlider->setLength(_videoLength);
-                _repeatABButton->setEnabled(true);
-            }
-            else {
-                _timeSlider->setEnabled(false);
-                _repeatABButton->setEnabled(false);
-            }
+    case MplayerOutputParser::INFO_FILE_FORMAT:
+        _fileFormat = value;
+        break;
 
-            QSize oldVideoSize = _videoSize;
-            // ビデオドライバ,サイズの取得
-            if( _existVideo ) {
-                _usingVideoDriver = rxVideoDriverWH.cap(1);
-                _videoSize = QSize(rxVideoDriverWH.cap(2).toInt(), rxVideoDriverWH.cap(3).toInt());
-                if( _videoSize.width()<=0 || _videoSize.height()<=0 )
-                    _videoSize = ConfigData::data()->initSize;
-            }
-            else {
-                _usingVideoDriver.clear();
-                _videoSize = ConfigData::data()->initSize;
-            }
+    case MplayerOutputParser::INFO_CLIP_TITLE:
+        _infoLabel->setClipTitle(value);
+        break;
 
-            if( _controlFlags.testFlag(FLG_OPENED_PATH) ) {
-                _labelFrame->setText("0");
-                _labelFps->setText("0fps");
+    case MplayerOutputParser::INFO_CLIP_AUTHOR:
+        _infoLabel->setClipAuthor(value);
+        break;
 
-                // テキスト内容によってステータスバーの高さが変わる為、高さを固定にする
-                statusBar()->setFixedHeight(statusBar()->height());
+    case MplayerOutputParser::INFO_CLIP_COPYRIGHT:
+        _infoLabel->setClipCopyright(value);
+        break;
 
-                _elapsedTime = 0;
+    case MplayerOutputParser::INFO_CLIP_COMMENTS:
+        _infoLabel->setClipComments(value);
+        break;
 
-                _clipRect = QRect(0,0, _videoSize.width(),_videoSize.height());
-                _controlFlags &= ~FLG_OPENED_PATH;
-            }
-            else
-            if( _videoSize != oldVideoSize ) {
-                releaseClipping();
-            }
+    case MplayerOutputParser::INFO_NO_VIDEO:
+        _existVideo = false;
+        break;
 
-            if( isPeercastStream() ) {
-                _timerReconnect.start(6000); // 再スタート
-                _reconnectScore = 0;
-                _reconnectControlTimeAo = 0;
-                _reconnectControlTimeVo = 0;
+    case MplayerOutputParser::INFO_NO_AUDIO:
+        _existAudio = false;
+        break;
 
-                if( _channelInfo.status == ChannelInfo::ST_SEARCH )
-                    updateChannelInfo();
-            }
+    default:
+        break;
+    }
+}
 
-            _startTime = -1;
-            _currentTimeAo = 0;
-            _currentTimeVo = 0;
+void PurePlayer::mpClient_cacheUnderrun()
+{
+    if( !isStop() && isPeercastStream() )
+        _reconnectScore += 100;
+}
 
-            // ウィンドウリサイズ
-            if( _controlFlags.testFlag(FLG_RESIZE_WHEN_PLAYED) ) {
-                QSize size = calcVideoViewSizeFromThreshold(ConfigData::data()->suitableResizeValue);
-                if( !resizeFromVideoClient(size) )
-                    updateVideoScreenGeometry();
+void PurePlayer::mpClient_connecting()
+{
+    if( isStop() )
+        return;
 
-                _controlFlags &= ~FLG_RESIZE_WHEN_PLAYED;
-            }
-            else
-                updateVideoScreenGeometry();
+    if( _state != ST_PLAY ) {// ネットワークストリーミングでシークした場合も受信する。一時対応
+        updateTelemetryDisplay();
+        _infoLabel->setText(tr("接続中"));
+    }
+}
 
-            LogDialog::debug(debugPrefix + QString("videosize %1x%2").arg(_videoSize.width()).arg(_videoSize.height()));
-        }
-        else
-        if( line.startsWith("ID_PAUSED") )
-            setStatus(ST_PAUSE);
-        else
-        if( line.startsWith("Connecting to") ) {
-            if( _state != ST_PLAY )// ネットワークストリーミングでシークした場合も受信する。一時対応
-                _infoLabel->setText(tr("接続中"));
+void PurePlayer::mpClient_cacheSizeSet()
+{
+    if( isStop() )
+        return;
+
+    if( isPeercastStream() ) {
+        if( _controlFlags.testFlag(FLG_RECONNECT_WHEN_PLAYED) ) { // 再接続(peercast)は再生後行う
+            reconnectPeercast();
+            _controlFlags &= ~FLG_RECONNECT_WHEN_PLAYED;
         }
-        else
-        if( line.startsWith("Cache size set to") ) {
-            if( isPeercastStream() ) {
-                if( _controlFlags.testFlag(FLG_RECONNECT_WHEN_PLAYED) ) { // 再接続(peercast)は再生後行う
-                    reconnectPeercast();
-                    _controlFlags &= ~FLG_RECONNECT_WHEN_PLAYED;
-                }
 
-                updateChannelInfo();
+        updateChannelInfo();
 
-                _timerReconnect.start(6000);
-                _reconnectScore = 0;
-            }
-        }
-        else
-        if( rxCacheFill.indexIn(line) != -1 )
-            _infoLabel->setText(tr("Cache") + QString(": %1%").arg(rxCacheFill.cap(1), 5));
-        else
-        if( rxGenIndex.indexIn(line) != -1 )
-            _infoLabel->setText(tr("Index生成中") + QString(": %1%").arg(rxGenIndex.cap(1), 2));
-        else
-        if( rxLength.indexIn(line) != -1 )
-            _videoLength = rxLength.cap(1).toDouble();
-        else
-        if( rxSeekable.indexIn(line) != -1 )
-            _isSeekable = rxSeekable.cap(1).toInt();
-        else
-        if( rxTitle.indexIn(line) != -1 )
-            _infoLabel->setClipTitle(rxTitle.cap(1));
-        else
-        if( rxAuthor.indexIn(line) != -1 )
-            _infoLabel->setClipAuthor(rxAuthor.cap(1));
-        else
-        if( rxCopyright.indexIn(line) != -1 )
-            _infoLabel->setClipCopyright(rxCopyright.cap(1));
-        else
-        if( rxComments.indexIn(line) != -1 )
-            _infoLabel->setClipComments(rxComments.cap(1));
-        else
-        if( line.startsWith("Video: no video") )
-            _existVideo = false;
-        else
-        if( line.startsWith("Audio: no sound") )
-            _existAudio = false;
-        else
-        if( rxFileFormat.indexIn(line) != -1 ) {
-            _fileFormat = rxFileFormat.cap(1);
-            if( _fileFormat.size() == 0 )
-                _fileFormat = rxFileFormat.cap(2);
-        }
+        _timerReconnect.start(6000);
+        _reconnectScore = 0;
+    }
+}
+
+void PurePlayer::mpClient_cacheFill(double percent)
+{
+    if( !isStop() ) {
+        _telemetry.setInfoText(tr("Cache") + QString(": %1%").arg(percent, 5, 'f', 2));
+        requestTelemetryDisplay();
     }
+}
 
-//  if( line.startsWith("ID_EXIT=QUIT") )
-//      ;
-//  else
-    if( line.startsWith("ID_EXIT=EOF") )
-        _controlFlags |= FLG_EOF;
+void PurePlayer::mpClient_generatingIndex(int percent)
+{
+    if( !isStop() ) {
+        _telemetry.setInfoText(tr("Index生成中") + QString(": %1%").arg(percent, 2));
+        requestTelemetryDisplay();
+    }
+}
+
+// VO:行、または映像が無い場合のStarting playback...行を受信した
+void PurePlayer::mpClient_videoOutputReady(const QString& videoDriver, const QSize& videoSize)
+{
+    const QString debugPrefix = "PurePlayer::mpClient_videoOutputReady(): ";
+
+    if( isStop() )
+        return;
+
+    if( !_trackStartMetric.isEmpty() ) {
+        Metrics::sample(_trackStartMetric, Metrics::elapsedMsec(_trackStartTime));
+        _trackStartMetric.clear();
+    }
+
+    setStatus(ST_PLAY);
+
+    if( isMute() )
+        mute(true);
+
+    if( _speedRate != 1.0 )
+        setSpeedRate(_speedRate);
+
+    // フィルタはファイル毎に起動時の状態から作り直されるので、再生中に変更した状態へ合わせる
+    _chainAudioOutput = _launchAudioOutput;
+    if( _audioOutput != _chainAudioOutput )
+        applyAudioOutputFilter();
+
+    if( _deinterlace != _launchDeinterlace )
+        applyDeinterlace();
+
+    _controlFlags |= FLG_HIDE_DISPLAY_MESSAGE; //mpCmd("osd 0");
+
+    setVolume(_volume);
+    setContrast(_videoProfile.contrast, true);
+    setBrightness(_videoProfile.brightness, true);
+    setSaturation(_videoProfile.saturation, true);
+    setHue(_videoProfile.hue, true);
+    setGamma(_videoProfile.gamma, true);
+
+    _controlFlags &= ~FLG_HIDE_DISPLAY_MESSAGE; //mpCmd("osd 1");
+
+    // mplayerプロセスの子プロセスIDを取得する
+    _mpClient->receiveMplayerChildProcess();
+
+    _timeLabel->setTotalTime(_videoLength);
+    _playlist->setCurrentTrackTime(_videoLength);
+
+    updatePrefetch();
+
+    if( _isSeekable ) {
+        _timeSlider->setLength(_videoLength);
+        _repeatABButton->setEnabled(true);
+    }
+    else {
+        _timeSlider->setEnabled(false);
+        _repeatABButton->setEnabled(false);
+    }
+
+    QSize oldVideoSize = _videoSize;
+    // ビデオドライバ,サイズの取得
+    if( _existVideo ) {
+        _usingVideoDriver = videoDriver;
+        _videoSize = videoSize;
+        if( _videoSize.width()<=0 || _videoSize.height()<=0 )
+            _videoSize = ConfigData::data()->initSize;
+    }
+    else {
+        _usingVideoDriver.clear();
+        _videoSize = ConfigData::data()->initSize;
+    }
+
+    if( _controlFlags.testFlag(FLG_OPENED_PATH) ) {
+        _labelFrame->setText("0");
+        _labelFps->setText("0fps");
+
+        // テキスト内容によってステータスバーの高さが変わる為、高さを固定にする
+        statusBar()->setFixedHeight(statusBar()->height());
+
+        _elapsedTime = 0;
+
+        _clipRect = QRect(0,0, _videoSize.width(),_videoSize.height());
+        _controlFlags &= ~FLG_OPENED_PATH;
+    }
     else
-    if( rxScreenshot.indexIn(line) != -1 ) {
-        QString file = rxScreenshot.cap(1);
-        QString newName = genDateTimeSaveFileName(QFileInfo(file).suffix());
+    if( _videoSize != oldVideoSize ) {
+        releaseClipping();
+    }
 
-        Task::push(new RenameFileTask(file, newName, this));
+    if( isPeercastStream() ) {
+        _timerReconnect.start(6000); // 再スタート
+        _reconnectScore = 0;
+        _reconnectControlTimeAo = 0;
+        _reconnectControlTimeVo = 0;
 
-        _infoLabel->setText(tr("保存: スクリーンショット"), 3000);
+        if( _channelInfo.status == ChannelInfo::ST_SEARCH )
+            updateChannelInfo();
+    }
+
+    _startTime = -1;
+    _currentTimeAo = 0;
+    _currentTimeVo = 0;
+
+    // ウィンドウリサイズ
+    if( _controlFlags.testFlag(FLG_RESIZE_WHEN_PLAYED) ) {
+        QSize size = calcVideoViewSizeFromThreshold(ConfigData::data()->suitableResizeValue);
+        if( !resizeFromVideoClient(size) )
+            updateVideoScreenGeometry();
+
+        _controlFlags &= ~FLG_RESIZE_WHEN_PLAYED;
     }
     else
-    if( rxScreenshotError.indexIn(line) != -1 )
-        _infoLabel->setText(tr("エラー: スクリーンショット保存"), 3000);
+        updateVideoScreenGeometry();
+
+    storeIdentifyCache();
+
+    LogDialog::debug(debugPrefix + QString("videosize %1x%2").arg(_videoSize.width()).arg(_videoSize.height()));
+}
+
+void PurePlayer::mpClient_paused()
+{
+    if( !isStop() )
+        setStatus(ST_PAUSE);
+}
+
+void PurePlayer::mpClient_timePosAnswered(double time)
+{
+    _seekScheduler->timePosAnswered(time);
+}
+
+void PurePlayer::mpClient_eof()
+{
+    _controlFlags |= FLG_EOF;
+}
+
+// queueNextTrack()で追加したトラックの再生へmplayerが移った。
+// 停止せずに、openCommonProcess()と同様にパスを切り替える
+void PurePlayer::mpClient_queuedFileStarted()
+{
+    const QString debugPrefix = "PurePlayer::mpClient_queuedFileStarted(): ";
+
+    QString path = _queuedNextPath;
+    _queuedNextPath.clear();
+
+    if( isStop() )
+        return;
+
+    // 追加後にプレイリストが変更された場合は、改めて次のトラックを開く
+    if( _playlist->nextTrackPath() != path || !_playlist->upCurrentTrackRow() ) {
+        LogDialog::debug(debugPrefix + "playlist changed " + path, QColor(255,0,0));
+        _controlFlags |= FLG_EOF;
+        if( !playNext() )
+            stop();
+
+        return;
+    }
+
+    LogDialog::print(QString("[%1]PurePlayer: mplayer next file -------------")
+                        .arg(QTime::currentTime().toString()), QColor(106,129,198));
+    LogDialog::print("PurePlayer: " + path);
+
+    setCurrentPath(path);
+
+    _existAudio = true;
+    _existVideo = true;
+    _controlFlags &= ~FLG_EOF;
+    _controlFlags &= ~FLG_RESIZE_WHEN_PLAYED;
+    _seekScheduler->reset();
+    applyIdentifyCache();
+
+    _trackStartTime = Metrics::now();
+    _trackStartMetric = "playback.track_start_ms.queued";
+    _advanceGapMetric = "playlist.advance_gap_ms.gapless";
+
+    if( _playlistDialog != NULL )
+        _playlistDialog->scrollToCurrentTrackHidden();
+}
+
+void PurePlayer::mpClient_screenshotSaved(const QString& file)
+{
+    QString newName = genDateTimeSaveFileName(QFileInfo(file).suffix());
+
+    Task::push(new RenameFileTask(file, newName, this));
+
+    _infoLabel->setText(tr("保存: スクリーンショット"), 3000);
+}
+
+void PurePlayer::mpClient_screenshotFailed()
+{
+    _infoLabel->setText(tr("エラー: スクリーンショット保存"), 3000);
 }
 
 void PurePlayer::recProcess_finished()
@@ -2696,6 +2863,33 @@ void PurePlayer::timerFps_timeout()
     _fpsCount = 0;
 }
 
+// 変化した表示値のみウィジェットへ反映する
+void PurePlayer::updateTelemetryDisplay()
+{
+    _timerTelemetry.stop();
+
+    int fields = _telemetry.takeDirtyFields();
+    if( fields & PlaybackTelemetry::FIELD_TIME )
+        _timeLabel->setTime(_telemetry.time());
+
+    if( fields & PlaybackTelemetry::FIELD_POSITION )
+        _timeSlider->setPosition(_telemetry.position());
+
+    if( fields & PlaybackTelemetry::FIELD_FRAME )
+        _labelFrame->setText(QString::number(_telemetry.frame()));
+
+    if( fields & PlaybackTelemetry::FIELD_INFO_TEXT )
+        _infoLabel->setText(_telemetry.infoText());
+}
+
+// 表示値の反映を予約する。ステータス行の受信頻度に関わらず、
+// 反映はDISPLAY_INTERVAL毎に最大1回にまとめる
+void PurePlayer::requestTelemetryDisplay()
+{
+    if( _telemetry.isDirty() && !_timerTelemetry.isActive() )
+        _timerTelemetry.start();
+}
+
 void PurePlayer::menuContext_aboutToHide()
 {
 #ifdef Q_OS_WIN32
@@ -2813,6 +3007,12 @@ void PurePlayer::configDialog_applied()
     else
         LogDialog::dialog()->setMaximumBlockCount(0);
 
+    // 問い合わせ間隔の変更は再起動せずに反映する
+    if( !restartMplayer && ConfigData::data()->pollPlaybackStatus )
+        _mpClient->setPollInterval(ConfigData::data()->pollInterval);
+
+    updatePrefetch();
+
     if( restartMplayer ) {
         setCurrentDirectory();
 
@@ -2840,10 +3040,13 @@ bool PurePlayer::checkRestartFromConfigData(const ConfigData::Data& oldData, con
     if( newData.useSoftWareVideoEq != oldData.useSoftWareVideoEq )
         return true;
 
-    if( newData.useCacheSize != oldData.useCacheSize )
+    // キャッシュサイズはネットワークストリームのみに指定するので、ローカルファイルの再生には影響しない
+    bool stream = !QUrl(_path).scheme().isEmpty();
+
+    if( stream && newData.useCacheSize != oldData.useCacheSize )
         return true;
 
-    if( newData.useCacheSize
+    if( stream && newData.useCacheSize
         && newData.cacheStreamSize != oldData.cacheStreamSize )
     {
         return true;
@@ -2861,6 +3064,9 @@ bool PurePlayer::checkRestartFromConfigData(const ConfigData::Data& oldData, con
     if( newData.useMplayerPath != oldData.useMplayerPath )
         return true;
 
+    if( newData.pollPlaybackStatus != oldData.pollPlaybackStatus )
+        return true;
+
     if( newData.useMplayerPath
         && newData.mplayerPath != oldData.mplayerPath )
     {
@@ -2872,19 +3078,109 @@ bool PurePlayer::checkRestartFromConfigData(const ConfigData::Data& oldData, con
 
 void PurePlayer::mpCmd(const QString& command)
 {
-    _mpProcess->command(command);
+    _mpClient->command(command);
     LogDialog::debug("PurePlayer::mpCmd(): " + command);
 }
 
+// -idleで起動したmplayerの再生リストへ、プレイリストの次のトラックを追加する
+void PurePlayer::queueNextTrack()
+{
+    if( isClipping() || (_repeatStartTime>=0 && _repeatEndTime>=0) )
+        return;
+
+    QString path = _playlist->nextTrackPath();
+    if( path.isEmpty() || path.contains('"') || !QUrl(path).scheme().isEmpty() )
+        return;
+
+    _queuedNextPath = path;
+    _mpClient->queueFile(path);
+
+    LogDialog::debug("PurePlayer::queueNextTrack(): " + path);
+}
+
+// 再生中にプレイリストの次のトラックの先頭をページキャッシュへ読み込んでおく。
+// 次のトラックが変わった場合は読み込み中のものを中止する
+void PurePlayer::updatePrefetch()
+{
+    QString path = _playlist->nextTrackPath();
+    if( isStop() || !ConfigData::data()->prefetchNextTrack
+        || path.isEmpty() || !QUrl(path).scheme().isEmpty() )
+    {
+        _prefetcher->cancel();
+        return;
+    }
+
+    _prefetcher->setBudget((qint64)ConfigData::data()->prefetchSize * 1024 * 1024);
+    _prefetcher->prefetch(path);
+}
+
+// ローカルファイルの場合、前回の-identifyの結果から、mplayerの出力を待たずに
+// 再生時間、シーク可否を設定し、ウィンドウサイズを合わせておく。
+// 実際の値はmplayerの出力で設定し直す
+void PurePlayer::applyIdentifyCache()
+{
+    IdentifyCache::Entry entry;
+    if( isPeercastStream() || !QUrl(_path).scheme().isEmpty()
+        || !IdentifyCache::find(_path, &entry) || entry.lengthOnly )
+    {
+        return;
+    }
+
+    _videoLength = entry.length;
+    _seekScheduler->setLength(_videoLength);
+    _isSeekable = entry.seekable;
+    _fileFormat = entry.fileFormat;
+    _timeLabel->setTotalTime(_videoLength);
+    if( _isSeekable )
+        _timeSlider->setLength(_videoLength);
+
+    if( _controlFlags.testFlag(FLG_OPENED_PATH) && _controlFlags.testFlag(FLG_RESIZE_WHEN_PLAYED)
+        && entry.existVideo && entry.videoSize.width() > 0 && entry.videoSize.height() > 0 )
+    {
+        _videoSize = entry.videoSize;
+        _clipRect = QRect(0,0, _videoSize.width(),_videoSize.height());
+
+        QSize size = calcVideoViewSizeFromThreshold(ConfigData::data()->suitableResizeValue);
+        if( !resizeFromVideoClient(size) )
+            updateVideoScreenGeometry();
+    }
+
+    LogDialog::debug("PurePlayer::applyIdentifyCache(): " + _path);
+}
+
+void PurePlayer::storeIdentifyCache()
+{
+    if( isPeercastStream() || !QUrl(_path).scheme().isEmpty() || _videoLength <= 0 )
+        return;
+
+    IdentifyCache::Entry entry;
+    entry.length = _videoLength;
+    entry.seekable = _isSeekable;
+    entry.fileFormat = _fileFormat;
+    entry.existVideo = _existVideo;
+    entry.existAudio = _existAudio;
+    if( _existVideo )
+        entry.videoSize = _videoSize;
+
+    IdentifyCache::store(_path, entry);
+}
+
 void PurePlayer::stopInternal()
 {
     const QString debugPrefix = "PurePlayer::stopInternal(): ";
     LogDialog::debug(debugPrefix + "start-");
 
-//  if( _mpProcess->state() != QProcess::Running )
+//  if( _mpClient->state() != QProcess::Running )
         setStatus(ST_STOP);
 
-    _mpProcess->terminateWaitForFinished();
+    _queuedNextPath.clear();
+    _advanceGapMetric.clear();
+    _prefetcher->cancel();
+
+    if( ConfigData::data()->keepMplayerIdle )
+        _mpClient->stopFile();
+    else
+        _mpClient->terminate();
 
     LogDialog::debug(debugPrefix + "-end");
 }
@@ -2914,9 +3210,9 @@ void PurePlayer::buttonPlayPauseClicked()
 void PurePlayer::playCommonProcess()
 {
     LogDialog::debug("PurePlayer::playCommonProcess(): start");
-    if( _mpProcess->state() != QProcess::NotRunning ) {
+    if( _mpClient->state() != QProcess::NotRunning && !_mpClient->isIdle() ) {
         LogDialog::debug(tr("PurePlayer::playCommonProcess(): running %1")
-                                        .arg(_mpProcess->state()), QColor(255,0,0));
+                                        .arg(_mpClient->state()), QColor(255,0,0));
         return;
     }
 
@@ -2928,6 +3224,7 @@ void PurePlayer::playCommonProcess()
     _controlFlags &= ~FLG_EXPLICITLY_STOPPED;
     _controlFlags &= ~FLG_RECONNECTED;
     setStatus(ST_READY);
+    applyIdentifyCache();
 
     QStringList args;
 
@@ -2993,14 +3290,10 @@ void PurePlayer::playCommonProcess()
     default: break;
     }
 
-    args << "-softvol-max";
-    switch( _volumeFactor ) {
-    case VF_ONE_THIRD: args << "36.7"; break;
-    case VF_DOUBLE   : args << "220"; break;
-    case VF_TRIPLE   : args << "330"; break;
-    case VF_NORMAL   :
-    default          : args << "110";
-    }
+    args << "-softvol-max" << QString::number(SOFTVOL_MAX);
+
+    _launchAudioOutput = _audioOutput;
+    _launchDeinterlace = _deinterlace;
 
     if( !QUrl(_path).scheme().isEmpty() ) {
         if( ConfigData::data()->useCacheSize )
@@ -3016,12 +3309,18 @@ void PurePlayer::playCommonProcess()
     }
 
     if( _controlFlags.testFlag(FLG_SEEK_WHEN_PLAYED) ) {
+        updateTelemetryDisplay();
         args << "-ss" << QString::number(_timeLabel->time());
         _controlFlags &= ~FLG_SEEK_WHEN_PLAYED;
     }
 
+    // 問い合わせモードではステータス行を出力させない
+    if( ConfigData::data()->pollPlaybackStatus )
+        args << "-quiet";
+    else
+        args << "-noquiet";
+
     args
-    << "-noquiet"
     << "-identify"
     << "-af-add" << "scaletempo"
     << "-osdlevel" << "0"
@@ -3031,7 +3330,7 @@ void PurePlayer::playCommonProcess()
     << "-framedrop"
     << "-zoom"
     << "-nokeepaspect"
-    << "-volume" << (isPeercastStream()||isMute() ? "0" : QString::number(_volume))
+    << "-volume" << (isPeercastStream()||isMute() ? "0" : mplayerVolume())
     << "-softvol"
     << "-prefer-ipv4"
     << "-nomouseinput"
@@ -3052,6 +3351,41 @@ void PurePlayer::playCommonProcess()
 
     << "-idx";
 
+    _trackStartTime = Metrics::now();
+    _queuedNextPath.clear();
+    _idleSession = false;
+
+    // ローカルファイルの場合、-idleで起動したmplayerを残して次のファイルの再生に使う。
+    // 起動オプションが同じ場合のみloadfileで読み込む
+    if( ConfigData::data()->keepMplayerIdle && !isPeercastStream()
+        && QUrl(_path).scheme().isEmpty() && !_path.contains('"') && !args.contains("-ss") )
+    {
+        args << "-idle" << "-msglevel" << "global=6";
+        _idleSession = true;
+
+        QStringList launchArgs = args;
+        int index = launchArgs.indexOf("-volume"); // 音量は再生開始後に設定し直す
+        if( index != -1 )
+            launchArgs.erase(launchArgs.begin() + index, launchArgs.begin() + index + 2);
+
+        if( _mpClient->isIdle() && launchArgs == _idleLaunchArgs ) {
+            LogDialog::print(QString("[%1]PurePlayer: mplayer loadfile -------------")
+                                .arg(QTime::currentTime().toString()), QColor(106,129,198));
+            LogDialog::print("PurePlayer: " + _path);
+
+            _trackStartMetric = "playback.track_start_ms.loadfile";
+            _seekScheduler->reset();
+            _mpClient->setPollInterval(ConfigData::data()->pollPlaybackStatus ? ConfigData::data()->pollInterval : 0);
+            _mpClient->loadFile(_path);
+            return;
+        }
+
+        _idleLaunchArgs = launchArgs;
+    }
+
+    if( _mpClient->isIdle() ) // 起動オプションが変わった
+        _mpClient->terminate();
+
     if( isPeercastStream() ) {
         if( _playNoSound )
             args << "-nosound";
@@ -3071,8 +3405,10 @@ void PurePlayer::playCommonProcess()
                         .arg(QTime::currentTime().toString()), QColor(106,129,198));
     LogDialog::print(QString("PurePlayer: %1 %2").arg(mplayerPath).arg(args.join(" ")));
 
-    _mpProcess->start(mplayerPath, args, QIODevice::ReadWrite);
-    _mpProcess->waitForStarted();
+    _trackStartMetric = "playback.track_start_ms.spawn";
+    _seekScheduler->reset();
+    _mpClient->setPollInterval(ConfigData::data()->pollPlaybackStatus ? ConfigData::data()->pollInterval : 0);
+    _mpClient->start(mplayerPath, args);
 }
 
 void PurePlayer::saveVideoProfileToDefault()
@@ -3349,6 +3685,64 @@ QSize PurePlayer::calcVideoViewSizeFromThreshold(int threshold)
     return correctToValidVideoSize(rc.size(), _videoSize);
 }
 
+// -softvol-maxをSOFTVOL_MAXで固定した場合の、音量の倍率を掛けたmplayerの音量
+QString PurePlayer::mplayerVolume()
+{
+    double softvolMax;
+    switch( _volumeFactor ) {
+    case VF_ONE_THIRD: softvolMax = 36.7; break;
+    case VF_DOUBLE   : softvolMax = 220; break;
+    case VF_TRIPLE   : softvolMax = 330; break;
+    case VF_NORMAL   :
+    default          : softvolMax = 110;
+    }
+
+    return QString::number(_volume * softvolMax / SOFTVOL_MAX, 'f', 2);
+}
+
+// 音声出力のフィルタをaf_del、af_addで再生中に切り替える
+void PurePlayer::applyAudioOutputFilter()
+{
+    static const char* const filters[] = {
+        "",                         // AO_STEREO
+        "extrastereo=0",            // AO_MONAURAL
+        "channels=2:2:0:0:0:1",     // AO_LEFT
+        "channels=2:2:1:0:1:1",     // AO_RIGHT
+    };
+
+    if( _chainAudioOutput == _audioOutput )
+        return;
+
+    QString oldFilter = filters[_chainAudioOutput];
+    QString newFilter = filters[_audioOutput];
+
+    if( !oldFilter.isEmpty() )
+        mpCmd("af_del " + oldFilter.section('=', 0, 0));
+
+    if( !newFilter.isEmpty() )
+        mpCmd("af_add " + newFilter);
+
+    _chainAudioOutput = _audioOutput;
+}
+
+// yadifはdeinterlaceプロパティで有効、無効を切り替えられる。
+// 起動時と異なるフィルタが必要な場合は切り替えられないのでfalseを返す
+bool PurePlayer::applyDeinterlace()
+{
+    if( _launchDeinterlace != DI_YADIF && _launchDeinterlace != DI_YADIF_DOUBLE )
+        return _deinterlace == _launchDeinterlace;
+
+    if( _deinterlace == _launchDeinterlace )
+        mpCmd("set_property deinterlace 1");
+    else
+    if( _deinterlace == DI_NO_DEINTERLACE )
+        mpCmd("set_property deinterlace 0");
+    else
+        return false;
+
+    return true;
+}
+
 QSize PurePlayer::calcFullVideoSizeFromVideoViewSize(QSize viewSize)
 {
     int w = _videoSize.width() * viewSize.width()/(double)_clipRect.width() + 0.5;
@@ -3582,6 +3976,10 @@ bool PurePlayer::whetherMuteArea(QPoint mousePos)
 */
 void PurePlayer::setStatus(const STATE s)
 {
+    // 保留中の表示値を先に反映し、以降の表示はここで設定したものを優先する
+    updateTelemetryDisplay();
+    _telemetry.clear();
+
     switch( s ) {
     case ST_PLAY:
         _state = s;
@@ -3604,7 +4002,6 @@ void PurePlayer::setStatus(const STATE s)
         if( _existVideo ) {
             _timerFps.start(1000);
             _fpsCount = 0;
-            _oldFrame = 0;
 
             if( ConfigData::data()->autoHideMouseCursor )
                 _mouseCursor->startAutoHide();
@@ -25,6 +25,8 @@
 #include "videosettings.h"
 #include "configdata.h"
 #include "peercast.h"
+#include "playbacktelemetry.h"
+#include "metrics.h"
 
 class QWidget;
 class QActionGroup;
@@ -34,7 +36,10 @@ class QPushButton;
 class QNetworkAccessManager;
 class QNetworkReply;
 
-class MplayerProcess;
+class MplayerClient;
+struct MplayerStatusBatch;
+class SeekScheduler;
+class Prefetcher;
 class RecordingProcess;
 class ControlButton;
 class TimeSlider;
@@ -167,6 +172,8 @@ protected slots:
 
 protected:
     enum STATE { ST_STOP, ST_PAUSE, ST_READY, ST_PLAY };
+    enum { QUEUE_NEXT_TRACK_TIME = 5 };  // 次のトラックをmplayerへ追加する、終了までの残り時間(秒)
+    enum { SOFTVOL_MAX = 330 };          // -softvol-max。音量の倍率はmplayerへ送る音量で調整する
     enum CONTROL_FLAG {
         FLG_NONE                        = 0,
         FLG_CURSOR_IN_WINDOW            = 1,       // ウィンドウの中にカーソル
@@ -209,7 +216,11 @@ protected:
     void middleClickResize();
     void setCurrentDirectory();
     void openCommonProcess(const QString& path);
+    void setCurrentPath(const QString& path);
     void playCommonProcess();
+    void queueNextTrack();
+    void applyIdentifyCache();
+    void storeIdentifyCache();
     void saveInteractiveSettings();
     void loadInteractiveSettings();
     bool checkRestartFromConfigData(const ConfigData::Data& oldData, const ConfigData::Data& newData);
@@ -220,6 +231,9 @@ protected:
     QSize calcVideoViewSizeForResize(const QSize& viewSize, int percent);
     QSize calcVideoViewSizeForResize(int percent);
     QSize calcVideoViewSizeFromThreshold(int threshold);
+    QString mplayerVolume();
+    void applyAudioOutputFilter();
+    bool applyDeinterlace();
     QSize calcFullVideoSizeFromVideoViewSize(QSize viewSize);
 
     bool containsInClipWindow(const QPoint& pos);
@@ -230,12 +244,27 @@ protected:
     void closeAllOtherDialog();
 
 private slots:
-    void mpProcess_finished();
-    void mpProcess_error(QProcess::ProcessError);
-    void mpProcess_outputLine(const QString& line);
+    void mpClient_finished();
+    void mpClient_error(QProcess::ProcessError);
+    void mpClient_statusBatch(const MplayerStatusBatch& batch);
+    void mpClient_messageLine(const QString& line);
+    void mpClient_identifyInfo(int info, const QString& value);
+    void mpClient_cacheUnderrun();
+    void mpClient_connecting();
+    void mpClient_cacheSizeSet();
+    void mpClient_cacheFill(double percent);
+    void mpClient_generatingIndex(int percent);
+    void mpClient_videoOutputReady(const QString& videoDriver, const QSize& videoSize);
+    void mpClient_paused();
+    void mpClient_timePosAnswered(double time);
+    void mpClient_eof();
+    void mpClient_queuedFileStarted();
+    void mpClient_screenshotSaved(const QString& file);
+    void mpClient_screenshotFailed();
     void recProcess_finished();
     void recProcess_outputLine(const QString& line);
     void updateShowInterface();
+    void updatePrefetch();
     void peercast_gotChannelInfo(const ChannelInfo&);
     void actGroupAudioOutput_changed(QAction*);
     void actGroupVolumeFactor_changed(QAction*);
@@ -243,6 +272,7 @@ private slots:
     void actGroupDeinterlace_changed(QAction*);
     void timerReconnect_timeout();
     void timerFps_timeout();
+    void updateTelemetryDisplay();
     void menuContext_aboutToHide();
     void clipWindow_changedTranslucentDisplay(bool);
     void clipWindow_triggeredShow();
@@ -259,6 +289,7 @@ private:
     bool whetherMuteArea(int mouseLocalY);
 //  bool whetherMuteArea(QPoint mousePos);
     void setStatus(const STATE);
+    void requestTelemetryDisplay();
 
 #ifdef Q_OS_WIN32
     void initColorKey();
@@ -266,7 +297,9 @@ private:
 #endif
 
 private:
-    MplayerProcess*   _mpProcess;
+    MplayerClient*    _mpClient;
+    SeekScheduler*    _seekScheduler;
+    Prefetcher*       _prefetcher;
     RecordingProcess* _recProcess;
 #ifdef Q_OS_WIN32
     QRgb _colorKey;
@@ -303,7 +336,19 @@ private:
 
     QTimer          _timerFps;
     quint16         _fpsCount;
-    uint            _oldFrame;
+
+    PlaybackTelemetry _telemetry;
+    QTimer          _timerTelemetry;
+
+    QStringList     _idleLaunchArgs;    // -idleで起動したmplayerの起動オプション(音量を除く)
+    bool            _idleSession;       // -idleで起動したmplayerで再生している
+    QString         _queuedNextPath;    // mplayerの再生リストへ追加した次のトラック
+    qint64          _lastStatusTime;    // 最後に受信したステータスの受信時刻
+    QString         _advanceGapMetric;  // トラック間の間隔を記録する計測値名
+    MetricsSampler  _sampleGuiDelay;
+    MetricsSampler  _sampleBatchLines;
+    qint64          _trackStartTime;
+    QString         _trackStartMetric;  // 再生開始までの時間を記録する計測値名
 
     VideoSettings::VideoProfile _videoProfile;
     uint            _videoSettingsModifiedId;
@@ -312,6 +357,9 @@ private:
     VOLUME_FACTOR_MODE _volumeFactor;
     ASPECT_RATIO       _aspectRatio;
     DEINTERLACE_MODE   _deinterlace;
+    AUDIO_OUTPUT_MODE  _launchAudioOutput;  // mplayerの起動時のフィルタ
+    DEINTERLACE_MODE   _launchDeinterlace;
+    AUDIO_OUTPUT_MODE  _chainAudioOutput;   // 再生中のファイルのフィルタ
     bool            _isMute;
     bool            _alwaysShowStatusBar;
     bool            _playNoSound;
@@ -0,0 +1,155 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtGlobal>
+#include "seekscheduler.h"
+#include "metrics.h"
+#include "logdialog.h"
+
+SeekScheduler::SeekScheduler(QObject* parent) : QObject(parent)
+{
+    _timerComplete.setSingleShot(true);
+    _timerComplete.setInterval(COMPLETE_TIMEOUT);
+    connect(&_timerComplete, SIGNAL(timeout()), this, SLOT(timerComplete_timeout()));
+
+    _length = 0;
+    reset();
+}
+
+void SeekScheduler::seekRelative(double sec)
+{
+    if( _hasPending ) {
+        // 保留中の要求へ移動量を加える
+        _pendingValue += sec;
+        ++_pendingCount;
+        Metrics::count("seek.collapsed");
+    }
+    else {
+        _hasPending = true;
+        _pendingRelative = true;
+        _pendingValue = sec;
+        _pendingCount = 1;
+    }
+
+    if( !_inFlight )
+        send();
+}
+
+void SeekScheduler::seekAbsolute(double sec)
+{
+    if( _hasPending ) {
+        ++_pendingCount;
+        Metrics::count("seek.collapsed");
+    }
+    else
+        _pendingCount = 1;
+
+    _hasPending = true;
+    _pendingRelative = false;
+    _pendingValue = sec;
+
+    if( !_inFlight )
+        send();
+}
+
+void SeekScheduler::statusTick(double time)
+{
+    _currentTime = time;
+}
+
+// タイムアウト後に届いた前のシークの応答では完了としない様、送った数だけ応答を待つ
+void SeekScheduler::timePosAnswered(double time)
+{
+    if( _markers <= 0 )
+        return;
+
+    --_markers;
+    if( _inFlight && _markers == 0 )
+        complete(time);
+}
+
+void SeekScheduler::reset()
+{
+    _timerComplete.stop();
+    _currentTime = 0;
+    _inFlight = false;
+    _markers = 0;
+    _sentTime = 0;
+    _hasPending = false;
+    _pendingRelative = false;
+    _pendingValue = 0;
+    _pendingCount = 0;
+}
+
+void SeekScheduler::timerComplete_timeout()
+{
+    if( !_inFlight )
+        return;
+
+    LogDialog::debug("SeekScheduler::timerComplete_timeout(): ", QColor(255,0,0));
+    Metrics::count("seek.timeout");
+
+    _inFlight = false;
+    if( _hasPending )
+        send();
+}
+
+void SeekScheduler::send()
+{
+    double target = _pendingRelative ? _currentTime + _pendingValue : _pendingValue;
+    if( target < 0 )
+        target = 0;
+    else if( _length > 0 && target > _length )
+        target = _length;
+
+    QString command;
+    if( _pendingRelative )
+        command.sprintf("seek %.1f 0", _pendingValue);
+    else {
+        if( _length <= 0 ) { // _lengthが0の場合の処理が未実装
+            _hasPending = false;
+            return;
+        }
+
+        double percent = target / _length * 100;
+        command.sprintf("seek %.1f 1", percent);            // パーセントによる指定
+//      command.sprintf("seek %.1f 2", target);             // 時間による直接指定
+                                                            // mplayer1では時間直接指定にバグあり
+    }
+
+    Metrics::sample("seek.batch_size", _pendingCount);
+
+    _inFlight = true;
+    ++_markers;
+    _sentTime = Metrics::now();
+    _hasPending = false;
+    _pendingCount = 0;
+    _timerComplete.start();
+
+    emit requestCommand(command);
+    emit requestCommand("pausing_keep_force get_property time_pos");
+}
+
+void SeekScheduler::complete(double time)
+{
+    Metrics::sample("seek.latency_ms", Metrics::elapsedMsec(_sentTime));
+
+    _timerComplete.stop();
+    _inFlight = false;
+    _currentTime = time;
+
+    if( _hasPending )
+        send();
+}
@@ -0,0 +1,67 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SEEKSCHEDULER_H
+#define SEEKSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+
+// mplayerへのシーク要求を調停する。
+// 実行中のシークは常に1つまでとし、完了前の要求は最新の目標位置へまとめて保留する。
+// シークの直後にget_property time_posを送り、その応答で完了とする。
+// mplayerはシークを実行してから後続のコマンドを処理する為、応答はシーク後の位置になる。
+class SeekScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum { COMPLETE_TIMEOUT = 2000 };   // 完了を確認できない場合に次のシークを許可するまでの時間(ms)
+
+    SeekScheduler(QObject* parent);
+
+    void setLength(double sec) { _length = sec; }
+    void seekRelative(double sec);
+    void seekAbsolute(double sec);
+    void statusTick(double time);
+    void timePosAnswered(double time);
+    void reset();
+    bool isSeeking() const { return _inFlight; }
+
+signals:
+    void requestCommand(const QString& command);
+
+private slots:
+    void timerComplete_timeout();
+
+private:
+    void send();
+    void complete(double time);
+
+    double _length;
+    double _currentTime;        // 最後に受け取った再生位置
+
+    bool   _inFlight;
+    int    _markers;            // 応答を待っているget_property time_posの数
+    qint64 _sentTime;
+    QTimer _timerComplete;
+
+    bool   _hasPending;
+    bool   _pendingRelative;
+    double _pendingValue;       // 相対指定の場合は移動量、絶対指定の場合は位置(秒)
+    int    _pendingCount;       // 保留中にまとめた要求数
+};
+
+#endif // SEEKSCHEDULER_H
@@ -0,0 +1,98 @@
+# 本体のソース。main.cpp以外をtestsのプロジェクトからも読み込む
+DEPENDPATH += $$PWD
+INCLUDEPATH += $$PWD
+QT += network
+
+HEADERS += \
+    $$PWD/pureplayer.h \
+    $$PWD/peercast.h \
+    $$PWD/process.h \
+    $$PWD/processtree.h \
+    $$PWD/linebuffer.h \
+    $$PWD/mplayerstatus.h \
+    $$PWD/mplayerline.h \
+    $$PWD/mplayeroutputparser.h \
+    $$PWD/mplayerworker.h \
+    $$PWD/mplayerteardown.h \
+    $$PWD/mplayercommandqueue.h \
+    $$PWD/seekscheduler.h \
+    $$PWD/prefetcher.h \
+    $$PWD/startuptrace.h \
+    $$PWD/identifycache.h \
+    $$PWD/durationprober.h \
+    $$PWD/jsonreader.h \
+    $$PWD/peercastclient.h \
+    $$PWD/metrics.h \
+    $$PWD/playbacktelemetry.h \
+    $$PWD/controlbutton.h \
+    $$PWD/timeslider.h \
+    $$PWD/infolabel.h \
+    $$PWD/timelabel.h \
+    $$PWD/configdata.h \
+    $$PWD/videosettings.h \
+    $$PWD/playlist.h \
+    $$PWD/commonmenu.h \
+    $$PWD/commonlib.h \
+    $$PWD/task.h \
+    $$PWD/windowcontroller.h \
+    $$PWD/mousecursor.h \
+    \
+    $$PWD/logdialog.h \
+    $$PWD/commonspinbox.h \
+    $$PWD/configdialog.h \
+    $$PWD/opendialog.h \
+    $$PWD/videoadjustdialog.h \
+    $$PWD/playlistdialog.h \
+    $$PWD/inputdialog.h \
+    $$PWD/aboutdialog.h \
+    $$PWD/clipwindow.h
+
+SOURCES += \
+    $$PWD/pureplayer.cpp \
+    $$PWD/peercast.cpp \
+    $$PWD/process.cpp \
+    $$PWD/processtree.cpp \
+    $$PWD/linebuffer.cpp \
+    $$PWD/mplayerstatus.cpp \
+    $$PWD/mplayerline.cpp \
+    $$PWD/mplayeroutputparser.cpp \
+    $$PWD/mplayerworker.cpp \
+    $$PWD/mplayerteardown.cpp \
+    $$PWD/mplayercommandqueue.cpp \
+    $$PWD/seekscheduler.cpp \
+    $$PWD/prefetcher.cpp \
+    $$PWD/startuptrace.cpp \
+    $$PWD/identifycache.cpp \
+    $$PWD/durationprober.cpp \
+    $$PWD/jsonreader.cpp \
+    $$PWD/peercastclient.cpp \
+    $$PWD/metrics.cpp \
+    $$PWD/timeslider.cpp \
+    $$PWD/infolabel.cpp \
+    $$PWD/timelabel.cpp \
+    $$PWD/configdata.cpp \
+    $$PWD/videosettings.cpp \
+    $$PWD/playlist.cpp \
+    $$PWD/commonmenu.cpp \
+    $$PWD/commonlib.cpp \
+    $$PWD/task.cpp \
+    $$PWD/windowcontroller.cpp \
+    $$PWD/mousecursor.cpp \
+    \
+    $$PWD/logdialog.cpp \
+    $$PWD/configdialog.cpp \
+    $$PWD/videoadjustdialog.cpp \
+    $$PWD/playlistdialog.cpp \
+    $$PWD/inputdialog.cpp \
+    $$PWD/clipwindow.cpp
+
+FORMS += \
+    $$PWD/logdialog.ui \
+    $$PWD/configdialog.ui \
+    $$PWD/opendialog.ui \
+    $$PWD/videoadjustdialog.ui \
+    $$PWD/playlistdialog.ui \
+    $$PWD/inputdialog.ui \
+    $$PWD/aboutdialog.ui
+
+RESOURCES += $$PWD/resource.qrc
@@ -0,0 +1,95 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QStringList>
+#include "startuptrace.h"
+#include "metrics.h"
+#include "logdialog.h"
+
+StartupTrace::StartupTrace()
+{
+    _startTime = 0;
+    _active = false;
+
+    for(int i=0; i < STAGE_COUNT; ++i)
+        _marks[i] = -1;
+}
+
+void StartupTrace::begin(const QString& kind, qint64 startTime)
+{
+    if( _active )
+        cancel();
+
+    _kind = kind;
+    _startTime = startTime;
+    _active = true;
+
+    for(int i=0; i < STAGE_COUNT; ++i)
+        _marks[i] = -1;
+}
+
+// 各段階は最初の1回のみ記録する
+void StartupTrace::mark(STAGE stage, qint64 time)
+{
+    if( !_active || _marks[stage] >= 0 )
+        return;
+
+    _marks[stage] = time;
+
+    if( stage == STAGE_FIRST_STATUS )
+        finish();
+}
+
+// 最初のステータス行の前に停止した場合。途中までの値は記録しない
+void StartupTrace::cancel()
+{
+    if( !_active )
+        return;
+
+    _active = false;
+    Metrics::count("startup." + _kind + ".canceled");
+}
+
+void StartupTrace::finish()
+{
+    _active = false;
+
+    QStringList spans;
+    for(int i=0; i < STAGE_COUNT; ++i) {
+        if( _marks[i] < 0 )
+            continue;
+
+        double msec = (_marks[i] - _startTime) / 1000.0;
+        QString name = stageName((STAGE)i);
+
+        Metrics::sample(QString("startup.%1.%2_ms").arg(_kind).arg(name), msec);
+        spans << QString("%1=%2ms").arg(name).arg(msec, 0, 'f', 1);
+    }
+
+    LogDialog::print(QString("[startup] %1: %2").arg(_kind).arg(spans.join(" ")),
+                     QColor(106,129,198));
+}
+
+const char* StartupTrace::stageName(STAGE stage)
+{
+    switch( stage ) {
+    case STAGE_SPAWN:        return "spawn";
+    case STAGE_FIRST_OUTPUT: return "first_output";
+    case STAGE_FILE_FORMAT:  return "file_format";
+    case STAGE_VIDEO_OUTPUT: return "video_output";
+    case STAGE_FIRST_STATUS: return "first_status";
+    default:                 return "";
+    }
+}
@@ -0,0 +1,54 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+
+// 再生開始から最初のステータス行までの各段階の経過時間を記録する。
+// 時刻はMetrics::now()の値を使う。
+// 最初のステータス行で1回の計測を終え、各段階の値をMetricsの分布へ追加し、ログへ出力する
+class StartupTrace
+{
+public:
+    enum STAGE {
+        STAGE_SPAWN,            // プロセスの起動
+        STAGE_FIRST_OUTPUT,     // 最初の出力行
+        STAGE_FILE_FORMAT,      // ファイル形式の検出
+        STAGE_VIDEO_OUTPUT,     // VO:又はStarting playback...
+        STAGE_FIRST_STATUS,     // 最初のステータス行
+        STAGE_COUNT,
+    };
+
+    StartupTrace();
+
+    void begin(const QString& kind, qint64 startTime);  // kindは計測値名に使う(spawn, loadfile等)
+    void mark(STAGE stage, qint64 time);
+    void cancel();
+    bool isActive() const { return _active; }
+
+private:
+    void finish();
+
+    static const char* stageName(STAGE stage);
+
+    QString _kind;
+    qint64  _startTime;
+    qint64  _marks[STAGE_COUNT];    // 未到達の段階は-1
+    bool    _active;
+};
+
+#endif // STARTUPTRACE_H
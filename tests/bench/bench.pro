@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = tst_bench
+DEPENDPATH += . ../../src
+INCLUDEPATH += . ../../src
+DEFINES += BENCH_DATA_DIR=\\\"$$PWD/data\\\"
+QT += testlib script
+QT -= gui
+CONFIG += console release
+CONFIG -= app_bundle
+
+HEADERS += \
+    mplayerstatus.h \
+    jsonreader.h \
+    metrics.h
+
+SOURCES += \
+    tst_bench.cpp \
+    mplayerstatus.cpp \
+    jsonreader.cpp \
+    metrics.cpp
@@ -0,0 +1,251 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QFile>
+#include <QRegExp>
+#include <QStringList>
+#include <QScriptEngine>
+#include "mplayerstatus.h"
+#include "jsonreader.h"
+
+// 本体の高速化を、置き換える前の実装と比べるベンチマーク。
+// 入力データはdata/に置く
+class TestBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void statusParse();
+    void statusParseRegExp();
+    void statusParseScanner();
+
+    void jsonParse();
+    void jsonParseScriptEngine();
+    void jsonParseReader();
+
+private:
+    static QByteArray  readFile(const QString& file);
+    static QStringList readLines(const QString& path);
+
+    QStringList _statusLog;     // 記録したmplayerの出力(ステータス行とそれ以外の行)
+    QByteArray  _channelInfo;   // PeerCastStationのgetChannelInfoの応答
+    QByteArray  _channelStatus; // PeerCastStationのgetChannelStatusの応答
+};
+
+void TestBench::initTestCase()
+{
+    // ステータス行の解析は、PUREPLAYER_BENCH_STATUS_LOGで実際のmplayerの出力を指定した場合のみ行う
+    QString statusLog = QString::fromLocal8Bit(qgetenv("PUREPLAYER_BENCH_STATUS_LOG"));
+    if( !statusLog.isEmpty() ) {
+        _statusLog = readLines(statusLog);
+        QVERIFY(!_statusLog.isEmpty());
+    }
+
+    _channelInfo = readFile("getchannelinfo.json");
+    _channelStatus = readFile("getchannelstatus.json");
+    QVERIFY(!_channelInfo.isEmpty() && !_channelStatus.isEmpty());
+}
+
+QByteArray TestBench::readFile(const QString& file)
+{
+    QFile f(QString(BENCH_DATA_DIR) + '/' + file);
+    if( !f.open(QIODevice::ReadOnly) )
+        return QByteArray();
+
+    return f.readAll();
+}
+
+// ステータス行は'\r'で終わる為、LineBufferと同じく'\r'、'\n'のどちらでも区切る
+QStringList TestBench::readLines(const QString& path)
+{
+    QFile f(path);
+    if( !f.open(QIODevice::ReadOnly) )
+        return QStringList();
+
+    return QString::fromLocal8Bit(f.readAll()).split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
+}
+
+// ---------------------------------------------------------------------------------------
+// 置き換える前のステータス行の解析(PurePlayer::mpProcess_outputLine()のQRegExp)
+static QRegExp rxStatus("^[AV]: *([0-9.-]+) (?:V: *([0-9.-]+))?");
+static QRegExp rxFrame(".+ (\\d+)\\/ *\\d+");
+
+static bool parseRegExp(const QString& line, double* time, double* timeVo, int* frame)
+{
+    if( rxStatus.indexIn(line) == -1 )
+        return false;
+
+    *time = rxStatus.cap(1).toDouble();
+    *timeVo = rxStatus.cap(2).toDouble();
+
+    *frame = -1;
+    if( rxFrame.indexIn(line) != -1 )
+        *frame = rxFrame.cap(1).toInt();
+
+    return true;
+}
+
+// 両方の実装が同じ行をステータス行とし、同じ値を得るか
+void TestBench::statusParse()
+{
+    if( _statusLog.isEmpty() )
+        QSKIP("PUREPLAYER_BENCH_STATUS_LOG is not set", SkipAll);
+
+    foreach(const QString& line, _statusLog) {
+        double time, timeVo;
+        int frame;
+        MplayerStatus status;
+
+        bool isStatus = parseRegExp(line, &time, &timeVo, &frame);
+        QCOMPARE(MplayerStatus::parse(line, &status), isStatus);
+        if( !isStatus )
+            continue;
+
+        QCOMPARE(status.time, time);
+        if( status.hasAudio && status.hasVideo )
+            QCOMPARE(status.timeVo, timeVo);
+        QCOMPARE(status.frame, frame);
+    }
+}
+
+void TestBench::statusParseRegExp()
+{
+    if( _statusLog.isEmpty() )
+        QSKIP("PUREPLAYER_BENCH_STATUS_LOG is not set", SkipAll);
+
+    double time, timeVo;
+    int frame;
+    int count = 0;
+
+    QBENCHMARK {
+        foreach(const QString& line, _statusLog) {
+            if( parseRegExp(line, &time, &timeVo, &frame) )
+                ++count;
+        }
+    }
+
+    QVERIFY(count > 0);
+}
+
+void TestBench::statusParseScanner()
+{
+    if( _statusLog.isEmpty() )
+        QSKIP("PUREPLAYER_BENCH_STATUS_LOG is not set", SkipAll);
+
+    MplayerStatus status;
+    int count = 0;
+
+    QBENCHMARK {
+        foreach(const QString& line, _statusLog) {
+            if( MplayerStatus::parse(line, &status) )
+                ++count;
+        }
+    }
+
+    QVERIFY(count > 0);
+}
+
+// ---------------------------------------------------------------------------------------
+// PeerCastStationの応答から、GetChannelInfoTaskが読む値
+struct ChannelValues
+{
+    QString name;
+    QString url;
+    int     bitrate;
+    int     localRelays;
+    int     totalRelays;
+    bool    isBroadcasting;
+    QString status;
+};
+
+// 置き換える前の解析(応答毎にQScriptEngineを作り、JSON.parseを評価する)
+static void readScriptEngine(const QByteArray& info, const QByteArray& status, ChannelValues* v)
+{
+    {
+        QScriptEngine engine;
+        QScriptValue value = engine.evaluate("JSON.parse").call(QScriptValue(),
+                                QScriptValueList() << QString::fromUtf8(info));
+
+        value = value.property("result").property("info");
+        v->name    = value.property("name").toString();
+        v->url     = value.property("url").toString();
+        v->bitrate = value.property("bitrate").toInt32();
+    }
+    {
+        QScriptEngine engine;
+        QScriptValue value = engine.evaluate("JSON.parse").call(QScriptValue(),
+                                QScriptValueList() << QString::fromUtf8(status));
+
+        value = value.property("result");
+        v->localRelays    = value.property("localRelays").toInt32();
+        v->totalRelays    = value.property("totalRelays").toInt32();
+        v->isBroadcasting = value.property("isBroadcasting").toBool();
+        v->status         = value.property("status").toString();
+    }
+}
+
+static void readJsonReader(const QByteArray& info, const QByteArray& status, ChannelValues* v)
+{
+    JsonReader jsonInfo(info);
+    v->name    = jsonInfo.toString("result.info.name");
+    v->url     = jsonInfo.toString("result.info.url");
+    v->bitrate = jsonInfo.toInt("result.info.bitrate");
+
+    JsonReader jsonStatus(status);
+    v->localRelays    = jsonStatus.toInt("result.localRelays");
+    v->totalRelays    = jsonStatus.toInt("result.totalRelays");
+    v->isBroadcasting = jsonStatus.toBool("result.isBroadcasting");
+    v->status         = jsonStatus.toString("result.status");
+}
+
+void TestBench::jsonParse()
+{
+    ChannelValues script, reader;
+    readScriptEngine(_channelInfo, _channelStatus, &script);
+    readJsonReader(_channelInfo, _channelStatus, &reader);
+
+    QVERIFY(!reader.name.isEmpty());
+    QCOMPARE(reader.name, script.name);
+    QCOMPARE(reader.url, script.url);
+    QCOMPARE(reader.bitrate, script.bitrate);
+    QCOMPARE(reader.localRelays, script.localRelays);
+    QCOMPARE(reader.totalRelays, script.totalRelays);
+    QCOMPARE(reader.isBroadcasting, script.isBroadcasting);
+    QCOMPARE(reader.status, script.status);
+}
+
+void TestBench::jsonParseScriptEngine()
+{
+    ChannelValues v;
+
+    QBENCHMARK {
+        readScriptEngine(_channelInfo, _channelStatus, &v);
+    }
+}
+
+void TestBench::jsonParseReader()
+{
+    ChannelValues v;
+
+    QBENCHMARK {
+        readJsonReader(_channelInfo, _channelStatus, &v);
+    }
+}
+
+QTEST_MAIN(TestBench)
+#include "tst_bench.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = tst_playlistadvance
+DEPENDPATH += .
+INCLUDEPATH += .
+QT += testlib
+CONFIG += release
+CONFIG -= app_bundle
+
+include(../../src/src.pri)
+
+SOURCES += \
+    tst_playlistadvance.cpp
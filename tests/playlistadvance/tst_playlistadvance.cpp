@@ -0,0 +1,109 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QDir>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include "pureplayer.h"
+#include "configdata.h"
+#include "metrics.h"
+
+// PurePlayerでプレイリストを通しで再生し、トラックの切り替えの間隔を測る。
+// 間隔はPurePlayerが記録するplaylist.advance_gap_ms(前のトラックの最後のステータスから、
+// 次のトラックの最初のステータスまで)を使う。
+// PUREPLAYER_BENCH_MEDIAに':'区切りで2つ以上のファイルを指定した場合のみ実行する。
+// 全てのファイルを最後まで再生する為、短いファイルを指定する
+class TestPlaylistAdvance : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void playlistAdvance_data();
+    void playlistAdvance();
+};
+
+// 利用者の設定、IdentifyCacheを書き換えない様に、設定ファイルの場所を一時ディレクトリにする
+void TestPlaylistAdvance::initTestCase()
+{
+    QString dir = QDir::tempPath() + QString("/tst_playlistadvance-%1").arg(QCoreApplication::applicationPid());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, dir);
+}
+
+void TestPlaylistAdvance::playlistAdvance_data()
+{
+    QTest::addColumn<bool>("keepMplayerIdle");
+    QTest::addColumn<QString>("metric");
+
+    // keepMplayerIdleが有効な場合のみ、queueNextTrack()でmplayerへ次のトラックを追加する
+    QTest::newRow("gapless") << true  << QString("playlist.advance_gap_ms.gapless");
+    QTest::newRow("restart") << false << QString("playlist.advance_gap_ms.restart");
+}
+
+void TestPlaylistAdvance::playlistAdvance()
+{
+    QFETCH(bool, keepMplayerIdle);
+    QFETCH(QString, metric);
+
+    QStringList files = QString::fromLocal8Bit(qgetenv("PUREPLAYER_BENCH_MEDIA"))
+                            .split(':', QString::SkipEmptyParts);
+    if( files.size() < 2 )
+        QSKIP("PUREPLAYER_BENCH_MEDIA is not set", SkipAll);
+
+    Metrics::clear();
+
+    PurePlayer* player = new PurePlayer();
+
+    // コンストラクタで設定を読み込む為、その後に変更する
+    ConfigData::data()->keepMplayerIdle = keepMplayerIdle;
+    QString program = QString::fromLocal8Bit(qgetenv("PUREPLAYER_BENCH_MPLAYER"));
+    if( !program.isEmpty() ) {
+        ConfigData::data()->useMplayerPath = true;
+        ConfigData::data()->mplayerPath = program;
+    }
+
+    player->show();
+    player->open(files);
+
+    // 最後のトラックの再生が終わり、停止するまで待つ
+    bool started = false;
+    QElapsedTimer timer;
+    timer.start();
+    while( timer.elapsed() < 600000 ) {
+        QTest::qWait(100);
+
+        if( !player->isStop() )
+            started = true;
+        else
+        if( started )
+            break;
+    }
+
+    delete player;
+
+    // 全ての切り替えが期待した経路を通ったか
+    Metrics::Summary summary;
+    QVERIFY(Metrics::summary(metric, &summary));
+    QCOMPARE(summary.count, (qint64)files.size() - 1);
+
+    qDebug("%s: mean %.1f ms, max %.1f ms", qPrintable(metric), summary.mean, summary.max);
+    QTest::setBenchmarkResult(summary.mean, QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(TestPlaylistAdvance)
+#include "tst_playlistadvance.moc"
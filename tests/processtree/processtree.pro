@@ -0,0 +1,15 @@
+TEMPLATE = app
+TARGET = tst_processtree
+DEPENDPATH += . ../../src
+INCLUDEPATH += . ../../src
+QT += testlib
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+HEADERS += \
+    processtree.h
+
+SOURCES += \
+    tst_processtree.cpp \
+    processtree.cpp
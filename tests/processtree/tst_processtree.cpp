@@ -0,0 +1,115 @@
+/*  Copyright (C) 2015 nel
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QProcess>
+#include <QSet>
+#include "processtree.h"
+
+// sh -c 'sleep 30 & echo $!; sleep 30 & echo $!; wait' を起動し、
+// シェルが出力した子プロセスIDとProcessTreeの結果を比べる
+class TestProcessTree : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void children();
+    void commandLine();
+    void isAlive();
+    void terminate();
+
+private:
+    QSet<Q_PID> spawnedChildren();
+
+    QProcess* _shell;
+    QList<Q_PID> _spawned;      // シェルが出力した子プロセスID
+};
+
+void TestProcessTree::init()
+{
+    _shell = new QProcess(this);
+    _shell->start("sh", QStringList() << "-c" << "sleep 30 & echo $!; sleep 30 & echo $!; wait");
+    QVERIFY(_shell->waitForStarted());
+
+    _spawned.clear();
+    while( _spawned.size() < 2 && _shell->waitForReadyRead(5000) ) {
+        while( _shell->canReadLine() )
+            _spawned << _shell->readLine().trimmed().toLongLong();
+    }
+
+    QCOMPARE(_spawned.size(), 2);
+}
+
+void TestProcessTree::cleanup()
+{
+    foreach(Q_PID pid, _spawned)
+        ProcessTree::terminate(pid);
+
+    _shell->waitForFinished(5000);
+    delete _shell;
+    _shell = NULL;
+}
+
+QSet<Q_PID> TestProcessTree::spawnedChildren()
+{
+    return ProcessTree::children(_shell->pid()).toSet();
+}
+
+void TestProcessTree::children()
+{
+    QCOMPARE(spawnedChildren(), _spawned.toSet());
+
+    // 子プロセスの無いプロセス
+    QVERIFY(ProcessTree::children(_spawned.first()).isEmpty());
+}
+
+void TestProcessTree::commandLine()
+{
+    foreach(Q_PID pid, _spawned)
+        QCOMPARE(ProcessTree::commandLine(pid), QString("sleep 30"));
+
+    QVERIFY(ProcessTree::commandLine(_shell->pid()).startsWith("sh -c "));
+}
+
+void TestProcessTree::isAlive()
+{
+    Q_PID pid = _spawned.first();
+
+    QVERIFY(ProcessTree::isAlive(pid));
+    QVERIFY(ProcessTree::isAlive(pid, "sleep"));
+    QVERIFY(!ProcessTree::isAlive(pid, "mplayer"));
+    QVERIFY(!ProcessTree::isAlive(0));
+}
+
+// 終了させた子プロセスはシェルのwaitで回収され、子の一覧から消える
+void TestProcessTree::terminate()
+{
+    Q_PID pid = _spawned.first();
+    QVERIFY(ProcessTree::terminate(pid));
+
+    QSet<Q_PID> expected = QSet<Q_PID>() << _spawned.last();
+    for(int i=0; i < 50 && spawnedChildren() != expected; ++i)
+        QTest::qWait(100);
+
+    QCOMPARE(spawnedChildren(), expected);
+    QVERIFY(!ProcessTree::isAlive(pid, "sleep"));
+
+    QVERIFY(!ProcessTree::terminate(0));
+}
+
+QTEST_MAIN(TestProcessTree)
+#include "tst_processtree.moc"
@@ -0,0 +1,3 @@
+# テスト、ベンチマーク。本体とは別に、このディレクトリでqmake、makeする
+TEMPLATE = subdirs
+SUBDIRS += processtree bench playlistadvance